@@ -0,0 +1,177 @@
+#pragma once
+
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TcpClient.h"
+#include "TcpServer.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace myMuduo;
+
+/*
+    L4转发服务器：客户端 => ProxyServer => upstream
+    splice模式下数据通过管道在内核中转发，copy模式下数据经过inputBuffer_和outputQueue_
+    每个客户端连接在自己的loop上用TcpClient非阻塞地连接upstream，连上之前暂停读取客户端
+    splice模式下一个方向读到EOF时只半关闭另一端，两个方向都结束后两个连接才关闭
+*/
+class ProxyServer
+{
+public:
+    ProxyServer(EventLoop *loop,
+                const InetAddress &listenAddr,
+                const InetAddress &upstreamAddr,
+                bool useSplice)
+        : server_(loop, listenAddr, "ProxyServer"),
+          upstreamAddr_(upstreamAddr), useSplice_(useSplice)
+    {
+        server_.setConnectionCallBack(
+            std::bind(&ProxyServer::onConnection, this, std::placeholders::_1));
+        server_.setMessageCallBack(
+            std::bind(&ProxyServer::onMessage, this, std::placeholders::_1,
+                      std::placeholders::_2, std::placeholders::_3));
+    }
+
+    void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
+
+    void start() { server_.start(); }
+
+private:
+    void onConnection(const TcpConnectionPtr &conn)
+    {
+        if (conn->connected())
+        {
+            // upstream连上之前不读取客户端，数据留在内核的接收缓冲区中
+            conn->stopRead();
+            std::shared_ptr<TcpClient> upstream = newUpstream(conn);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                upstreams_[conn->id()] = upstream;
+            }
+            upstream->connect();
+        }
+        else
+        {
+            std::shared_ptr<TcpClient> upstream = findUpstream(conn->id());
+            if (!upstream)
+            {
+                return;
+            }
+            TcpConnectionPtr upstreamConn = upstream->connection();
+            if (upstreamConn)
+            {
+                // upstream的连接关闭时再释放TcpClient
+                upstreamConn->shutdown();
+            }
+            else
+            {
+                // 还在连接upstream，直接放弃
+                upstream->stop();
+                removeUpstream(conn->getloop(), conn->id());
+            }
+        }
+    }
+
+    // copy模式：客户端数据拷贝到upstream的发送队列
+    void onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+    {
+        std::shared_ptr<TcpClient> upstream = findUpstream(conn->id());
+        TcpConnectionPtr upstreamConn =
+            upstream ? upstream->connection() : TcpConnectionPtr();
+        if (upstreamConn)
+        {
+            upstreamConn->send(buf);
+        }
+        else
+        {
+            buf->retrieveAll();
+        }
+    }
+
+    // 在客户端连接所在的loop上连接upstream，splice要求两个连接属于同一个loop
+    std::shared_ptr<TcpClient> newUpstream(const TcpConnectionPtr &client)
+    {
+        EventLoop *loop = client->getloop();
+        uint64_t id = client->id();
+        auto upstream = std::make_shared<TcpClient>(loop, upstreamAddr_,
+                                                    "ProxyServer-upstream");
+        std::weak_ptr<TcpConnection> weakClient(client);
+        upstream->setConnectionCallBack(
+            [this, weakClient, loop, id](const TcpConnectionPtr &conn)
+            {
+                TcpConnectionPtr client = weakClient.lock();
+                if (conn->connected())
+                {
+                    if (!client || !client->connected())
+                    {
+                        conn->shutdown();
+                        return;
+                    }
+                    if (useSplice_)
+                    {
+                        client->startSplice(conn);
+                        conn->startSplice(client);
+                    }
+                    client->startRead();
+                }
+                else
+                {
+                    if (client)
+                    {
+                        client->shutdown();
+                    }
+                    // 正在TcpClient的回调中，不能在这里析构它
+                    removeUpstream(loop, id);
+                }
+            });
+        upstream->setMessageCallBack(
+            [weakClient](const TcpConnectionPtr &, Buffer *buf, Timestamp)
+            {
+                TcpConnectionPtr client = weakClient.lock();
+                if (client)
+                {
+                    client->send(buf);
+                }
+                else
+                {
+                    buf->retrieveAll();
+                }
+            });
+        return upstream;
+    }
+
+    std::shared_ptr<TcpClient> findUpstream(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = upstreams_.find(id);
+        return it != upstreams_.end() ? it->second : nullptr;
+    }
+
+    // 放到本轮事件处理完之后析构TcpClient
+    void removeUpstream(EventLoop *loop, uint64_t id)
+    {
+        std::shared_ptr<TcpClient> upstream;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = upstreams_.find(id);
+            if (it == upstreams_.end())
+            {
+                return;
+            }
+            upstream = std::move(it->second);
+            upstreams_.erase(it);
+        }
+        loop->queueInLoop([upstream]() {});
+    }
+
+    TcpServer server_;
+    InetAddress upstreamAddr_;
+    bool useSplice_;
+    std::mutex mutex_;
+    // 客户端连接id => 到upstream的TcpClient
+    std::unordered_map<uint64_t, std::shared_ptr<TcpClient>> upstreams_;
+};
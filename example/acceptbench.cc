@@ -0,0 +1,95 @@
+#include "TcpServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*
+    测试连接建立和断开的吞吐量（每秒完成的连接数）
+    客户端线程不断地connect，服务端在连接建立后立即shutdown，
+    客户端读到EOF后close，一次完整的建立/断开记为一个连接
+    日志会打印到stdout，测试时建议重定向: ./acceptbench > /dev/null
+    使用方法: ./acceptbench [seconds] [clientThreads] [ioThreads]
+*/
+static const uint16_t kPort = 9004;
+
+static std::atomic<long> g_completed(0);
+static std::atomic<bool> g_stop(false);
+
+static void runClient()
+{
+    myMuduo::InetAddress addr(kPort);
+    char buf[64];
+    while (!g_stop)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (::connect(fd, addr.getSockAddr(), addr.getSockLen()) < 0)
+        {
+            ::close(fd);
+            ::usleep(1000);
+            continue;
+        }
+        while (::read(fd, buf, sizeof(buf)) > 0)
+        {
+        }
+        ::close(fd);
+        ++g_completed;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 5;
+    int clientThreads = argc > 2 ? atoi(argv[2]) : 4;
+    int ioThreads = argc > 3 ? atoi(argv[3]) : 0;
+    ::signal(SIGPIPE, SIG_IGN);
+
+    using namespace myMuduo;
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "AcceptBench",
+                     TcpServer::kReusePort);
+    server.setConnectionCallBack(
+        [](const TcpConnectionPtr &conn)
+        {
+            if (conn->connected())
+            {
+                conn->shutdown();
+            }
+        });
+    server.setThreadNum(ioThreads);
+    server.start();
+
+    std::thread timer(
+        [&]()
+        {
+            std::vector<std::thread> clients;
+            for (int i = 0; i < clientThreads; ++i)
+            {
+                clients.emplace_back(runClient);
+            }
+            auto start = std::chrono::steady_clock::now();
+            ::sleep(seconds);
+            g_stop = true;
+            for (std::thread &t : clients)
+            {
+                t.join();
+            }
+            double elapsed = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+            fprintf(stderr, "%ld connections in %.2fs, %.0f conn/s\n",
+                    g_completed.load(), elapsed, g_completed / elapsed);
+            loop.quit();
+            loop.wakeup();
+        });
+
+    loop.loop();
+    timer.join();
+    return 0;
+}
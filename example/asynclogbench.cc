@@ -0,0 +1,90 @@
+#include "AsyncLogging.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+    比较同步日志（直接fwrite到文件）和AsyncLogging的前端吞吐
+    每个线程调用LOG_INFO写n条日志，统计总耗时、每秒条数和单次调用的最大耗时
+    （同步日志在write阻塞时前端跟着阻塞，最大耗时能反映出来）
+    日志写到当前目录下的 asynclogbench.* 文件，测试结束后可以删除
+    使用方法: ./asynclogbench [threads] [messagesPerThread]
+*/
+using namespace myMuduo;
+
+static FILE *g_syncFile = nullptr;
+static std::atomic<long> g_maxLatencyUs(0);
+
+static double runThreads(int threads, long n)
+{
+    g_maxLatencyUs = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([n, t] {
+            long maxUs = 0;
+            for (long i = 0; i < n; ++i)
+            {
+                auto begin = std::chrono::steady_clock::now();
+                LOG_INFO("thread %d message %ld abcdefghijklmnopqrstuvwxyz", t,
+                         i);
+                long us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - begin)
+                              .count();
+                maxUs = std::max(maxUs, us);
+            }
+            long cur = g_maxLatencyUs;
+            while (maxUs > cur && !g_maxLatencyUs.compare_exchange_weak(cur, maxUs))
+            {
+            }
+        });
+    }
+    for (std::thread &w : workers)
+    {
+        w.join();
+    }
+    std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+    return sec.count();
+}
+
+int main(int argc, char *argv[])
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    long n = argc > 2 ? atol(argv[2]) : 200000;
+    long total = threads * n;
+    const off_t kRollSize = 500 * 1000 * 1000;
+
+    // 同步：每条日志在调用线程里写文件（stdio内部加锁）
+    g_syncFile = ::fopen("asynclogbench.sync.log", "w");
+    Logger::instance().setOutput(
+        [](const char *msg, size_t len) { ::fwrite(msg, 1, len, g_syncFile); },
+        [] { ::fflush(g_syncFile); });
+    double syncSec = runThreads(threads, n);
+    ::fclose(g_syncFile);
+    printf("sync : %ld messages in %.3fs, %.0f msg/s, max latency %ldus\n",
+           total, syncSec, total / syncSec, g_maxLatencyUs.load());
+
+    // 异步：前端只拷贝到内存缓冲区，后台线程批量写文件
+    {
+        AsyncLogging log("asynclogbench.async", kRollSize);
+        log.start();
+        Logger::instance().setOutput(
+            [&log](const char *msg, size_t len) { log.append(msg, len); },
+            [&log] { log.stop(); });
+        double asyncSec = runThreads(threads, n);
+        log.stop();
+        printf("async: %ld messages in %.3fs, %.0f msg/s, max latency %ldus, "
+               "dropped %lu\n",
+               total, asyncSec, total / asyncSec, g_maxLatencyUs.load(),
+               log.droppedMessages());
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "AsyncLogging.h"
+#include "BinaryLogging.h"
+#include "Logger.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+/*
+    比较调用点的开销：LOG_INFO（在调用线程格式化）和LOG_INFO_BIN（只记录参数）
+    前两项都把文本交给AsyncLogging写文件，第三项由BinaryLog直接写二进制文件
+    二进制文件可以用 ./logdecoder binlogbench.bin 还原
+    使用方法: ./binlogbench [threads] [messagesPerThread]
+*/
+using namespace myMuduo;
+
+// 返回每个线程平均每次调用的耗时（纳秒）
+template <typename F> static double runThreads(int threads, long n, F func)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([n, t, &func] {
+            for (long i = 0; i < n; ++i)
+            {
+                func(t, i);
+            }
+        });
+    }
+    for (std::thread &w : workers)
+    {
+        w.join();
+    }
+    std::chrono::duration<double, std::nano> ns =
+        std::chrono::steady_clock::now() - start;
+    return ns.count() / n;
+}
+
+int main(int argc, char *argv[])
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 1;
+    long n = argc > 2 ? atol(argv[2]) : 100000;
+    const off_t kRollSize = 500 * 1000 * 1000;
+
+    AsyncLogging asyncLog("binlogbench", kRollSize);
+    asyncLog.start();
+    auto toAsync = [&asyncLog](const char *msg, size_t len) {
+        asyncLog.append(msg, len);
+    };
+    Logger::instance().setOutput(toAsync, [&asyncLog] { asyncLog.stop(); });
+
+    double textNs = runThreads(threads, n, [](int t, long i) {
+        LOG_INFO("fd=%d events=%ld state=%s", t, i, "kConnected");
+    });
+    printf("LOG_INFO              : %8.1f ns/call\n", textNs);
+
+    BinaryLog &binLog = BinaryLog::instance();
+    binLog.startText(toAsync);
+    double binTextNs = runThreads(threads, n, [](int t, long i) {
+        LOG_INFO_BIN("fd=%d events=%ld state=%s", t, i, "kConnected");
+    });
+    binLog.stop();
+    printf("LOG_INFO_BIN (text)   : %8.1f ns/call, dropped %lu\n", binTextNs,
+           binLog.droppedRecords());
+
+    uint64_t droppedBefore = binLog.droppedRecords();
+    binLog.startFile("binlogbench.bin");
+    double binFileNs = runThreads(threads, n, [](int t, long i) {
+        LOG_INFO_BIN("fd=%d events=%ld state=%s", t, i, "kConnected");
+    });
+    binLog.stop();
+    printf("LOG_INFO_BIN (binary) : %8.1f ns/call, dropped %lu\n", binFileNs,
+           binLog.droppedRecords() - droppedBefore);
+
+    asyncLog.stop();
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "EventLoopThread.h"
+#include "LengthHeaderCodec.h"
+#include "Logger.h"
+#include "TcpClient.h"
+#include "TcpServer.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+/*
+    LengthHeaderCodec解码压测：客户端把batch条size字节的消息编码到一个Buffer中，
+    每次发送完成后再发一批，服务器用codec解码并统计消息条数和内容校验
+    头部类型：0为varint，2/4/8为对应字节数的大端整数
+    使用方法: ./codecbench [headerType] [size] [seconds]
+*/
+using namespace myMuduo;
+
+static const uint16_t kPort = 9051;
+static const int kBatch = 256;
+
+int main(int argc, char *argv[])
+{
+    LengthHeaderCodec::HeaderType type = static_cast<LengthHeaderCodec::HeaderType>(
+        argc > 1 ? atoi(argv[1]) : 4);
+    size_t size = argc > 2 ? atol(argv[2]) : 64;
+    double seconds = argc > 3 ? atof(argv[3]) : 3;
+
+    std::string payload(size, 'x');
+    std::atomic<long> frames(0);
+    std::atomic<long> corrupted(0);
+    LengthHeaderCodec serverCodec(
+        [&](const TcpConnectionPtr &, std::string_view frame, Timestamp)
+        {
+            if (frame.size() != payload.size() ||
+                memcmp(frame.data(), payload.data(), frame.size()) != 0)
+            {
+                ++corrupted;
+            }
+            ++frames;
+        },
+        type);
+
+    EventLoopThread serverThread(EventLoopThread::ThreadInitCallBack(),
+                                 "CodecServer");
+    EventLoop *serverLoop = serverThread.startLoop();
+    std::unique_ptr<TcpServer> server;
+    std::promise<void> started;
+    serverLoop->runInLoop(
+        [&]()
+        {
+            server.reset(
+                new TcpServer(serverLoop, InetAddress(kPort), "CodecServer"));
+            server->setConnectionCallBack([](const TcpConnectionPtr &) {});
+            server->setMessageCallBack(
+                [&serverCodec](const TcpConnectionPtr &conn, Buffer *buf,
+                               Timestamp receiveTime)
+                { serverCodec.onMessage(conn, buf, receiveTime); });
+            server->start();
+            started.set_value();
+        });
+    started.get_future().wait();
+
+    // 客户端只发送，编码一次之后每批都发送同一份数据
+    LengthHeaderCodec clientCodec(
+        [](const TcpConnectionPtr &, std::string_view, Timestamp) {}, type);
+    Buffer encoded;
+    for (int i = 0; i < kBatch; ++i)
+    {
+        clientCodec.appendFrame(&encoded, payload);
+    }
+    std::string batch(encoded.peek(), encoded.readableBytes());
+
+    EventLoop loop;
+    TcpClient client(&loop, InetAddress(kPort), "CodecClient");
+    client.setConnectionCallBack(
+        [&batch](const TcpConnectionPtr &conn)
+        {
+            if (conn->connected())
+            {
+                conn->send(batch);
+            }
+        });
+    client.setWriteCompleteCallBack([&batch](const TcpConnectionPtr &conn)
+                                    { conn->send(batch); });
+    client.connect();
+
+    long startCount = 0;
+    loop.runAfter(0.5, [&]() { startCount = frames; });
+    loop.runAfter(0.5 + seconds,
+                  [&]()
+                  {
+                      long n = frames - startCount;
+                      printf("header %d, %zu byte frames: %ld frames in %.1fs, "
+                             "%.0f frames/s, %ld corrupted\n",
+                             static_cast<int>(type), size, n, seconds,
+                             n / seconds, corrupted.load());
+                      client.disconnect();
+                      loop.quit();
+                  });
+    loop.loop();
+
+    std::promise<void> destroyed;
+    serverLoop->runInLoop(
+        [&]()
+        {
+            server.reset();
+            destroyed.set_value();
+        });
+    destroyed.get_future().wait();
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "TcpServer.h"
+
+#include <atomic>
+#include <malloc.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*
+    测试每个空闲连接在服务端占用的用户态内存
+    fork出的子进程建立N个连接，每个连接先发送bytes字节并等服务端回显（默认0，不收发数据），
+    之后不再收发数据，服务端在所有连接建立前后
+    分别统计堆上已分配的字节数（mallinfo2）和RSS，差值除以N即每个连接的开销
+    内核中socket自身的内存不计算在内
+    日志会打印到stdout，测试时建议重定向: ./connmembench > /dev/null
+    使用方法: ./connmembench [connections] [bytes]
+*/
+static const uint16_t kPort = 9005;
+
+static std::atomic<long> g_connected(0);
+static std::atomic<long> g_echoed(0); // 服务端回显的字节数
+
+// 客户端：建立n个连接，每个连接收发bytes字节，等待父进程的信号后全部关闭
+static void runClients(long n, size_t bytes, int readyFd)
+{
+    std::vector<char> buf(bytes, 'x');
+    myMuduo::InetAddress addr(kPort);
+    std::vector<int> fds;
+    for (long i = 0; i < n; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        while (::connect(fd, addr.getSockAddr(), addr.getSockLen()) < 0)
+        {
+            ::close(fd);
+            ::usleep(10 * 1000);
+            fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        }
+        if (bytes > 0)
+        {
+            ::write(fd, buf.data(), bytes);
+            for (size_t got = 0; got < bytes;)
+            {
+                ssize_t r = ::read(fd, buf.data(), bytes - got);
+                if (r <= 0)
+                {
+                    break;
+                }
+                got += r;
+            }
+        }
+        fds.push_back(fd);
+    }
+    char c;
+    ::read(readyFd, &c, 1);
+    for (int fd : fds)
+    {
+        ::close(fd);
+    }
+}
+
+static size_t heapBytes() { return mallinfo2().uordblks; }
+
+static size_t rssBytes()
+{
+    long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp)
+    {
+        if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+        {
+            resident = 0;
+        }
+        fclose(fp);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? atol(argv[1]) : 10000;
+    size_t bytes = argc > 2 ? atol(argv[2]) : 0;
+    ::signal(SIGPIPE, SIG_IGN);
+
+    // 父子进程各需要n个fd
+    rlimit limit;
+    ::getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &limit);
+
+    int pipefd[2];
+    if (::pipe(pipefd) < 0)
+    {
+        return 1;
+    }
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        ::close(pipefd[1]);
+        runClients(n, bytes, pipefd[0]);
+        ::_exit(0);
+    }
+    ::close(pipefd[0]);
+
+    using namespace myMuduo;
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "ConnMemBench");
+    server.setConnectionCallBack(
+        [](const TcpConnectionPtr &conn)
+        {
+            if (conn->connected())
+            {
+                ++g_connected;
+            }
+        });
+    server.setMessageCallBack(
+        [](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+        {
+            g_echoed += buf->readableBytes();
+            conn->send(buf);
+        });
+    server.start();
+
+    size_t heapBefore = heapBytes();
+    size_t rssBefore = rssBytes();
+    size_t heapAfter = 0;
+    size_t rssAfter = 0;
+
+    std::thread waiter(
+        [&]()
+        {
+            while (g_connected < n || g_echoed < static_cast<long>(n * bytes))
+            {
+                ::usleep(10 * 1000);
+            }
+            // 让loop处理完最后一个连接的回调
+            ::usleep(100 * 1000);
+            loop.queueInLoop(
+                [&]()
+                {
+                    heapAfter = heapBytes();
+                    rssAfter = rssBytes();
+                    loop.quit();
+                });
+            loop.wakeup();
+        });
+
+    loop.loop();
+    waiter.join();
+    ::write(pipefd[1], "x", 1);
+    ::waitpid(pid, nullptr, 0);
+
+    fprintf(stderr, "%ld idle connections (%zu bytes echoed each): heap %.0f "
+                    "bytes/conn, rss %.0f bytes/conn\n",
+            n, bytes, static_cast<double>(heapAfter - heapBefore) / n,
+            static_cast<double>(rssAfter - rssBefore) / n);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "TcpClient.h"
+#include "TcpServer.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+/*
+    TcpClient示例：clients个客户端连接同一进程中的echo服务器，
+    每个连接收到回显后立即把数据发回去（ping-pong），统计每秒往返次数
+    服务器在serverDelay秒后才开始监听，客户端连接被拒绝后按退避时间自动重连
+    使用方法: ./echoclient [clients] [seconds] [serverDelay]
+*/
+using namespace myMuduo;
+
+static const uint16_t kPort = 9006;
+
+int main(int argc, char *argv[])
+{
+    int numClients = argc > 1 ? atoi(argv[1]) : 10;
+    double seconds = argc > 2 ? atof(argv[2]) : 3;
+    double serverDelay = argc > 3 ? atof(argv[3]) : 1;
+
+    // 服务器运行在单独的线程中
+    EventLoopThread serverThread(EventLoopThread::ThreadInitCallBack(),
+                                 "EchoServer");
+    EventLoop *serverLoop = serverThread.startLoop();
+    std::unique_ptr<TcpServer> server(
+        new TcpServer(serverLoop, InetAddress(kPort), "EchoServer"));
+    server->setConnectionCallBack([](const TcpConnectionPtr &) {});
+    server->setMessageCallBack(
+        [](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+        { conn->send(buf); });
+
+    EventLoop loop;
+    std::atomic<long> roundTrips(0);
+    std::atomic<int> connected(0);
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for (int i = 0; i < numClients; ++i)
+    {
+        clients.emplace_back(
+            new TcpClient(&loop, InetAddress(kPort), "EchoClient"));
+        TcpClient *client = clients.back().get();
+        client->enableRetry();
+        client->setConnectionCallBack(
+            [&connected](const TcpConnectionPtr &conn)
+            {
+                if (conn->connected())
+                {
+                    ++connected;
+                    conn->send(std::string(64, 'x'));
+                }
+            });
+        client->setMessageCallBack(
+            [&roundTrips](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+            {
+                ++roundTrips;
+                conn->send(buf);
+            });
+        client->connect();
+    }
+
+    long startCount = 0;
+    loop.runAfter(serverDelay,
+                  [&]()
+                  {
+                      printf("server starts listening, %d clients connected\n",
+                             connected.load());
+                      server->start();
+                  });
+    // 给重连留出时间（前三次重试的间隔最多0.5+1+2秒），之后开始计数
+    loop.runAfter(serverDelay + 2,
+                  [&]()
+                  {
+                      printf("%d/%d clients connected\n", connected.load(),
+                             numClients);
+                      startCount = roundTrips;
+                  });
+    loop.runAfter(serverDelay + 2 + seconds,
+                  [&]()
+                  {
+                      long n = roundTrips - startCount;
+                      printf("%ld round trips in %.1fs, %.0f round trips/s\n",
+                             n, seconds, n / seconds);
+                      for (std::unique_ptr<TcpClient> &client : clients)
+                      {
+                          client->disconnect();
+                      }
+                      loop.quit();
+                  });
+    loop.loop();
+
+    // TcpServer要在自己的loop线程中析构
+    std::promise<void> destroyed;
+    serverLoop->runInLoop(
+        [&]()
+        {
+            server.reset();
+            destroyed.set_value();
+        });
+    destroyed.get_future().wait();
+    return 0;
+}
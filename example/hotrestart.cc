@@ -0,0 +1,62 @@
+#include "Logger.h"
+#include "TcpServer.h"
+
+#include <memory>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+/*
+    热升级示例：回显服务器，回复的数据前带上当前进程的pid
+    先启动一个进程，再启动第二个进程，第二个进程通过handoffPath从第一个进程取得监听fd，
+    第一个进程交出fd后停止accept，已有连接的响应发完之后退出，整个过程中不会有连接被拒绝
+    使用方法: ./hotrestart [port] [handoffPath]
+*/
+using namespace myMuduo;
+
+int main(int argc, char *argv[])
+{
+    uint16_t port = argc > 1 ? static_cast<uint16_t>(atoi(argv[1])) : 9006;
+    std::string path = argc > 2 ? argv[2] : "/tmp/myMuduo-hotrestart.sock";
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    std::unique_ptr<TcpServer> server;
+    // 有旧进程时继承它的监听fd，否则正常bind
+    int listenFd = ListenSocketHandoff::receive(path);
+    if (listenFd >= 0)
+    {
+        LOG_INFO("pid %d inherited listen fd %d \n", ::getpid(), listenFd);
+        server.reset(new TcpServer(&loop, listenFd, "HotRestart"));
+    }
+    else
+    {
+        server.reset(new TcpServer(&loop, InetAddress(port), "HotRestart"));
+    }
+
+    std::string pid = std::to_string(::getpid()) + ":";
+    server->setConnectionCallBack([](const TcpConnectionPtr &) {});
+    server->setMessageCallBack(
+        [&pid](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+        { conn->send(pid + buf->retrieveAllAsString()); });
+    server->start();
+
+    // 新进程取走监听fd之后，排空已有连接再退出
+    server->enableHandoff(path,
+                          [&]()
+                          {
+                              server->stop(10.0,
+                                           [&](size_t remaining)
+                                           {
+                                               if (remaining == 0)
+                                               {
+                                                   loop.quit();
+                                               }
+                                           });
+                          });
+    loop.loop();
+    fprintf(stderr, "pid %d exit\n", ::getpid());
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "BinaryLogging.h"
+
+#include <stdio.h>
+
+/*
+    把BinaryLog::startFile写出的二进制日志还原成文本，输出到stdout
+    使用方法: ./logdecoder file
+*/
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s file\n", argv[0]);
+        return 1;
+    }
+    long count = myMuduo::BinaryLog::decodeFile(
+        argv[1],
+        [](const char *msg, size_t len) { fwrite(msg, 1, len, stdout); });
+    if (count < 0)
+    {
+        fprintf(stderr, "%s: corrupted or unreadable\n", argv[1]);
+        return 1;
+    }
+    fprintf(stderr, "%ld records\n", count);
+    return 0;
+}
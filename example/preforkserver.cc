@@ -0,0 +1,60 @@
+#include "Logger.h"
+#include "Prefork.h"
+#include "SignalWatcher.h"
+#include "TcpServer.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+/*
+    多进程回显服务器，回复的数据前带上worker进程的pid
+    每个worker用SO_REUSEPORT监听同一个端口，kill -9某个worker后master会重启它，
+    kill master（SIGTERM）后所有worker排空连接后退出
+    使用方法: ./preforkserver [port] [workers] [threadsPerWorker]
+*/
+using namespace myMuduo;
+
+static int runWorker(uint16_t port, int threads)
+{
+    ::signal(SIGPIPE, SIG_IGN);
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port), "PreforkServer",
+                     TcpServer::kReusePort);
+    // 在server.start创建subloop线程之前接管SIGTERM，收到后排空连接再退出
+    SignalWatcher term(&loop, SIGTERM,
+                       [&](int)
+                       {
+                           server.stop(5.0,
+                                       [&](size_t remaining)
+                                       {
+                                           if (remaining == 0)
+                                           {
+                                               loop.quit();
+                                           }
+                                       });
+                       });
+
+    std::string pid = std::to_string(::getpid()) + ":";
+    server.setConnectionCallBack([](const TcpConnectionPtr &) {});
+    server.setMessageCallBack(
+        [&pid](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+        { conn->send(pid + buf->retrieveAllAsString()); });
+    server.setThreadNum(threads);
+    server.start();
+    loop.loop();
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint16_t port = argc > 1 ? static_cast<uint16_t>(atoi(argv[1])) : 9007;
+    int workers = argc > 2 ? atoi(argv[2]) : 4;
+    int threads = argc > 3 ? atoi(argv[3]) : 0;
+
+    Prefork prefork(workers, [port, threads](int)
+                    { return runWorker(port, threads); });
+    prefork.run();
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "ProxyServer.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+/*
+    转发吞吐量测试：client => ProxyServer => sink
+    client和sink使用阻塞socket，分别测试splice模式和copy模式
+    使用方法: ./proxybench [totalMB]
+*/
+static const uint16_t kSinkPort = 9001;
+static const uint16_t kProxyPort = 9002;
+
+static int listenOn(uint16_t port)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+    InetAddress addr(port);
+    ::bind(fd, addr.getSockAddr(), addr.getSockLen());
+    ::listen(fd, 16);
+    return fd;
+}
+
+static int connectTo(uint16_t port)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    InetAddress addr(port);
+    while (::connect(fd, addr.getSockAddr(), addr.getSockLen()) < 0)
+    {
+        ::usleep(10 * 1000);
+    }
+    return fd;
+}
+
+static double runOnce(bool useSplice, size_t totalBytes)
+{
+    int sinkListenFd = listenOn(kSinkPort);
+
+    // 转发服务器运行在单独的线程中，测试结束后退出loop
+    EventLoop *proxyLoop = nullptr;
+    std::mutex mutex;
+    std::thread proxyThread(
+        [&]()
+        {
+            EventLoop loop;
+            ProxyServer server(&loop, InetAddress(kProxyPort),
+                               InetAddress(kSinkPort), useSplice);
+            server.setThreadNum(1);
+            server.start();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                proxyLoop = &loop;
+            }
+            loop.loop();
+        });
+
+    size_t received = 0;
+    std::thread sinkThread(
+        [&]()
+        {
+            int fd = ::accept(sinkListenFd, nullptr, nullptr);
+            std::vector<char> buf(256 * 1024);
+            ssize_t n = 0;
+            while (received < totalBytes &&
+                   (n = ::read(fd, buf.data(), buf.size())) > 0)
+            {
+                received += n;
+            }
+            ::close(fd);
+        });
+
+    int clientFd = connectTo(kProxyPort);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> chunk(64 * 1024, 'x');
+    size_t sent = 0;
+    while (sent < totalBytes)
+    {
+        ssize_t n = ::write(clientFd, chunk.data(),
+                            std::min(chunk.size(), totalBytes - sent));
+        if (n <= 0)
+        {
+            break;
+        }
+        sent += n;
+    }
+    sinkThread.join();
+    auto end = std::chrono::steady_clock::now();
+
+    ::close(clientFd);
+    ::close(sinkListenFd);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        proxyLoop->quit();
+    }
+    proxyThread.join();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return received / seconds / (1024 * 1024);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t totalMB = argc > 1 ? atoi(argv[1]) : 2048;
+    size_t totalBytes = totalMB * 1024 * 1024;
+
+    double copyMBps = runOnce(false, totalBytes);
+    double spliceMBps = runOnce(true, totalBytes);
+    printf("copy   mode: %.1f MB/s\n", copyMBps);
+    printf("splice mode: %.1f MB/s\n", spliceMBps);
+
+    return 0;
+}
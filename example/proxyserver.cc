@@ -0,0 +1,23 @@
+#include "ProxyServer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// 使用方法: ./proxyserver [listenPort] [upstreamIp] [upstreamPort] [copy]
+// 默认监听8001端口，把数据以splice方式转发给127.0.0.1:8000（可以先启动testserver）
+int main(int argc, char *argv[])
+{
+    uint16_t listenPort = argc > 1 ? atoi(argv[1]) : 8001;
+    std::string upstreamIp = argc > 2 ? argv[2] : "127.0.0.1";
+    uint16_t upstreamPort = argc > 3 ? atoi(argv[3]) : 8000;
+    bool useSplice = !(argc > 4 && strcmp(argv[4], "copy") == 0);
+
+    EventLoop loop;
+    ProxyServer server(&loop, InetAddress(listenPort),
+                       InetAddress(upstreamPort, upstreamIp), useSplice);
+    server.setThreadNum(3);
+    server.start();
+    loop.loop();
+
+    return 0;
+}
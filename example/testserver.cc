@@ -1,6 +1,7 @@
 #include "Logger.h"
 #include "TcpServer.h"
 #include <functional>
+#include <iostream>
 #include <string>
 using namespace myMuduo;
 
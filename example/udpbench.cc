@@ -0,0 +1,136 @@
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "UdpServer.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+/*
+    UDP收包压测：senders个发送线程各用4个UdpSocket向服务器发送64字节的数据报，
+    服务器有threads个subloop，每个subloop一个SO_REUSEPORT的socket，
+    batch为一次recvmmsg/sendmmsg处理的数据报个数，batch为1时相当于逐个recvfrom/sendto
+    使用方法: ./udpbench [threads] [senders] [batch] [seconds]
+*/
+using namespace myMuduo;
+
+static const uint16_t kPort = 9031;
+static const int kSocketsPerSender = 4;
+
+struct Sender
+{
+    std::vector<std::shared_ptr<UdpSocket>> sockets;
+    std::atomic<bool> running{true};
+};
+
+// 每轮每个socket发满一个批次，然后把下一轮投递到队列末尾，让loop有机会处理其他事件
+static void sendRound(EventLoop *loop, Sender *sender, int batch)
+{
+    if (!sender->running)
+    {
+        return;
+    }
+    static const std::string payload(64, 'x');
+    InetAddress server(kPort);
+    for (std::shared_ptr<UdpSocket> &socket : sender->sockets)
+    {
+        for (int i = 0; i < batch; ++i)
+        {
+            socket->sendTo(payload, server);
+        }
+        socket->flush();
+    }
+    loop->queueInLoop([loop, sender, batch]() { sendRound(loop, sender, batch); });
+}
+
+int main(int argc, char *argv[])
+{
+    int numThreads = argc > 1 ? atoi(argv[1]) : 2;
+    int numSenders = argc > 2 ? atoi(argv[2]) : 2;
+    int batch = argc > 3 ? atoi(argv[3]) : UdpSocket::kDefaultBatchSize;
+    double seconds = argc > 4 ? atof(argv[4]) : 3;
+
+    EventLoopThread serverThread(EventLoopThread::ThreadInitCallBack(),
+                                 "UdpServer");
+    EventLoop *serverLoop = serverThread.startLoop();
+    std::unique_ptr<UdpServer> server;
+    std::promise<void> started;
+    serverLoop->runInLoop(
+        [&]()
+        {
+            server.reset(new UdpServer(serverLoop, InetAddress(kPort), "UdpBench"));
+            server->setThreadNum(numThreads);
+            server->setBatchSize(batch);
+            server->start();
+            started.set_value();
+        });
+    started.get_future().wait();
+
+    std::vector<std::unique_ptr<EventLoopThread>> threads;
+    std::vector<EventLoop *> loops;
+    std::vector<std::unique_ptr<Sender>> senders;
+    for (int i = 0; i < numSenders; ++i)
+    {
+        threads.emplace_back(new EventLoopThread(
+            EventLoopThread::ThreadInitCallBack(), "UdpSender"));
+        loops.push_back(threads.back()->startLoop());
+        senders.emplace_back(new Sender);
+        EventLoop *loop = loops.back();
+        Sender *sender = senders.back().get();
+        loop->runInLoop(
+            [loop, sender, batch]()
+            {
+                // 端口0由内核分配，不同的源端口被哈希到不同的服务器socket上
+                for (int j = 0; j < kSocketsPerSender; ++j)
+                {
+                    sender->sockets.push_back(std::make_shared<UdpSocket>(
+                        loop, InetAddress(0), false, batch));
+                }
+                sendRound(loop, sender, batch);
+            });
+    }
+
+    // 第一秒作为预热，不计入结果
+    sleep(1);
+    uint64_t startCount = server->receivedDatagrams();
+    usleep(static_cast<useconds_t>(seconds * 1000 * 1000));
+    uint64_t n = server->receivedDatagrams() - startCount;
+    printf("threads %d senders %d batch %d: %lu datagrams in %.1fs, %.0f "
+           "datagrams/s\n",
+           numThreads, numSenders, batch, n, seconds, n / seconds);
+
+    uint64_t sent = 0;
+    for (size_t i = 0; i < senders.size(); ++i)
+    {
+        Sender *sender = senders[i].get();
+        std::promise<void> stopped;
+        loops[i]->runInLoop(
+            [&]()
+            {
+                sender->running = false;
+                for (std::shared_ptr<UdpSocket> &socket : sender->sockets)
+                {
+                    sent += socket->sentDatagrams();
+                }
+                sender->sockets.clear();
+                stopped.set_value();
+            });
+        stopped.get_future().wait();
+    }
+    printf("sent %lu, received %lu\n", sent, server->receivedDatagrams());
+
+    std::promise<void> destroyed;
+    serverLoop->runInLoop(
+        [&]()
+        {
+            server.reset();
+            destroyed.set_value();
+        });
+    destroyed.get_future().wait();
+    return 0;
+}
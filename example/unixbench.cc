@@ -0,0 +1,102 @@
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "TcpClient.h"
+#include "TcpServer.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+/*
+    同一台机器上不同地址族的ping-pong对比：IPv4回环、IPv6回环、Unix域socket
+    一个客户端连接发送size字节，服务器原样回显，收到后立即再发，统计每秒往返次数
+    使用方法: ./unixbench [seconds] [size]
+*/
+using namespace myMuduo;
+
+static void runPingPong(const char *label,
+                        const InetAddress &addr,
+                        double seconds,
+                        size_t size)
+{
+    EventLoopThread serverThread(EventLoopThread::ThreadInitCallBack(),
+                                 "PingPongServer");
+    EventLoop *serverLoop = serverThread.startLoop();
+    std::unique_ptr<TcpServer> server;
+    std::promise<void> started;
+    serverLoop->runInLoop(
+        [&]()
+        {
+            server.reset(new TcpServer(serverLoop, addr, "PingPongServer"));
+            server->setConnectionCallBack([](const TcpConnectionPtr &) {});
+            server->setMessageCallBack(
+                [](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+                { conn->send(buf); });
+            server->start();
+            started.set_value();
+        });
+    started.get_future().wait();
+
+    EventLoop loop;
+    TcpClient client(&loop, addr, "PingPongClient");
+    long roundTrips = 0;
+    std::string message(size, 'x');
+    client.setConnectionCallBack(
+        [&](const TcpConnectionPtr &conn)
+        {
+            if (conn->connected())
+            {
+                conn->setTcpNoDelay(true);
+                conn->send(message);
+            }
+        });
+    client.setMessageCallBack(
+        [&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+        {
+            // 收齐一整条消息才算一次往返
+            if (buf->readableBytes() >= size)
+            {
+                ++roundTrips;
+                buf->retrieve(size);
+                conn->send(message);
+            }
+        });
+    client.connect();
+    loop.runAfter(seconds,
+                  [&]()
+                  {
+                      printf("%-6s %-34s %ld round trips in %.1fs, %.0f round "
+                             "trips/s\n",
+                             label, addr.toIpPort().c_str(), roundTrips,
+                             seconds, roundTrips / seconds);
+                      client.disconnect();
+                      loop.quit();
+                  });
+    loop.loop();
+
+    std::promise<void> destroyed;
+    serverLoop->runInLoop(
+        [&]()
+        {
+            server.reset();
+            destroyed.set_value();
+        });
+    destroyed.get_future().wait();
+}
+
+int main(int argc, char *argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 2;
+    size_t size = argc > 2 ? atol(argv[2]) : 64;
+
+    runPingPong("tcp4", InetAddress(9041), seconds, size);
+    runPingPong("tcp6", InetAddress(9042, "::1"), seconds, size);
+    runPingPong("unix", InetAddress::fromUnixPath("/tmp/mymuduo-unixbench.sock"),
+                seconds, size);
+    runPingPong("unix", InetAddress::fromUnixPath("@mymuduo-unixbench"),
+                seconds, size);
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "TcpConnection.h"
+#include "TcpServer.h"
+#include "UpstreamPool.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+/*
+    UpstreamPool示例：两个按行应答的后端（回复"端口:原请求"），
+    threads个IO线程各自建一个连接池，每个线程保持depth个流水线请求在途
+    运行到一半时关闭第二个后端，之后的请求全部由第一个后端处理
+    使用方法: ./upstreampool [threads] [depth] [seconds]
+*/
+using namespace myMuduo;
+
+static const uint16_t kPorts[] = {9021, 9022};
+
+// 一行是一个完整的响应
+static ssize_t parseLine(const Buffer *buf)
+{
+    const char *eol = static_cast<const char *>(
+        memchr(buf->peek(), '\n', buf->readableBytes()));
+    return eol ? eol - buf->peek() + 1 : 0;
+}
+
+struct Worker
+{
+    std::unique_ptr<UpstreamPool> pool;
+    std::atomic<long> ok{0};
+    std::atomic<long> failed{0};
+    bool running = true;
+};
+
+// 请求完成后立即发出下一个，保持在途的请求数不变
+static void issue(EventLoop *loop, Worker *worker)
+{
+    if (!worker->running)
+    {
+        return;
+    }
+    bool sent = worker->pool->send("ping\n",
+                                   [loop, worker](bool ok, std::string_view)
+                                   {
+                                       if (ok)
+                                       {
+                                           ++worker->ok;
+                                       }
+                                       else
+                                       {
+                                           ++worker->failed;
+                                       }
+                                       issue(loop, worker);
+                                   });
+    if (!sent)
+    {
+        // 还没有可用的连接，稍后再试
+        loop->runAfter(0.01, [loop, worker]() { issue(loop, worker); });
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int numThreads = argc > 1 ? atoi(argv[1]) : 2;
+    int depth = argc > 2 ? atoi(argv[2]) : 16;
+    double seconds = argc > 3 ? atof(argv[3]) : 4;
+    // 后端关闭时连接池可能正在写这条连接
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoopThread backendThread(EventLoopThread::ThreadInitCallBack(),
+                                  "Backend");
+    EventLoop *backendLoop = backendThread.startLoop();
+    std::vector<std::unique_ptr<TcpServer>> backends;
+    std::promise<void> listening;
+    backendLoop->runInLoop(
+        [&]()
+        {
+            for (uint16_t port : kPorts)
+            {
+                backends.emplace_back(
+                    new TcpServer(backendLoop, InetAddress(port), "Backend"));
+                std::string prefix = std::to_string(port) + ":";
+                backends.back()->setConnectionCallBack(
+                    [](const TcpConnectionPtr &) {});
+                backends.back()->setMessageCallBack(
+                    [prefix](const TcpConnectionPtr &conn, Buffer *buf,
+                             Timestamp)
+                    {
+                        ssize_t n;
+                        while ((n = parseLine(buf)) > 0)
+                        {
+                            std::string response(prefix);
+                            response.append(buf->peek(), n);
+                            buf->retrieve(n);
+                            conn->send(response);
+                        }
+                    });
+                backends.back()->start();
+            }
+            listening.set_value();
+        });
+    listening.get_future().wait();
+
+    std::vector<std::unique_ptr<EventLoopThread>> threads;
+    std::vector<EventLoop *> loops;
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back(new EventLoopThread(
+            EventLoopThread::ThreadInitCallBack(), "Worker"));
+        workers.emplace_back(new Worker);
+        EventLoop *loop = threads.back()->startLoop();
+        loops.push_back(loop);
+        Worker *worker = workers.back().get();
+        // 连接池属于这个IO线程，只在它的loop中创建、使用和析构
+        loop->runInLoop(
+            [loop, worker, depth]()
+            {
+                worker->pool.reset(
+                    new UpstreamPool(loop, "Upstream", parseLine));
+                for (uint16_t port : kPorts)
+                {
+                    worker->pool->addEndpoint(InetAddress(port));
+                }
+                worker->pool->setMaxFailures(1);
+                worker->pool->start();
+                for (int j = 0; j < depth; ++j)
+                {
+                    issue(loop, worker);
+                }
+            });
+    }
+
+    auto total = [&workers]()
+    {
+        long n = 0;
+        for (std::unique_ptr<Worker> &worker : workers)
+        {
+            n += worker->ok;
+        }
+        return n;
+    };
+
+    usleep(static_cast<useconds_t>(seconds / 2 * 1000 * 1000));
+    long half = total();
+    printf("%ld responses in %.1fs, stopping backend %u\n", half,
+           seconds / 2, kPorts[1]);
+    std::promise<void> stopped;
+    backendLoop->runInLoop(
+        [&]()
+        {
+            backends[1].reset();
+            stopped.set_value();
+        });
+    stopped.get_future().wait();
+
+    usleep(static_cast<useconds_t>(seconds / 2 * 1000 * 1000));
+    printf("%ld responses in %.1fs after stopping\n", total() - half,
+           seconds / 2);
+
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        Worker *worker = workers[i].get();
+        EventLoop *loop = loops[i];
+        std::promise<void> destroyed;
+        loop->runInLoop(
+            [&]()
+            {
+                worker->running = false;
+                for (const UpstreamPool::EndpointStatus &s :
+                     worker->pool->status())
+                {
+                    printf("worker %zu %s: connected %d, responses %lu, "
+                           "failures %lu, ejected %d\n",
+                           i, s.addr.toIpPort().c_str(), s.connected,
+                           s.responses, s.failures, s.ejected);
+                }
+                worker->pool.reset();
+                destroyed.set_value();
+            });
+        destroyed.get_future().wait();
+        printf("worker %zu: %ld ok, %ld failed\n", i, worker->ok.load(),
+               worker->failed.load());
+    }
+
+    std::promise<void> destroyed;
+    backendLoop->runInLoop(
+        [&]()
+        {
+            backends.clear();
+            destroyed.set_value();
+        });
+    destroyed.get_future().wait();
+    return 0;
+}
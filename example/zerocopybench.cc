@@ -0,0 +1,107 @@
+#include "Logger.h"
+#include "TcpServer.h"
+
+#include <chrono>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+/*
+    比较普通拷贝发送和MSG_ZEROCOPY发送每GB数据消耗的CPU时间
+    服务端在本进程中发送，接收端在fork出的子进程中读取并丢弃，保证统计的只是发送端的CPU
+    注意：loopback上内核会退化为延迟拷贝，真实网卡上零拷贝的收益更明显
+    使用方法: ./zerocopybench [totalMB] [chunkKB]
+*/
+static const uint16_t kPort = 9003;
+
+// 接收端：连接服务器，读到EOF为止
+static void runReceiver()
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    myMuduo::InetAddress addr(kPort);
+    while (::connect(fd, addr.getSockAddr(), addr.getSockLen()) < 0)
+    {
+        ::usleep(10 * 1000);
+    }
+    std::vector<char> buf(1024 * 1024);
+    while (::read(fd, buf.data(), buf.size()) > 0)
+    {
+    }
+    ::close(fd);
+}
+
+static double cpuSeconds()
+{
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+static void runOnce(size_t threshold, size_t totalBytes, size_t chunkBytes)
+{
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        runReceiver();
+        ::_exit(0);
+    }
+
+    using namespace myMuduo;
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "ZeroCopyBench");
+    SharedBuffer chunk(std::string(chunkBytes, 'x'));
+    double startCpu = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    server.setConnectionCallBack(
+        [&](const TcpConnectionPtr &conn)
+        {
+            if (!conn->connected())
+            {
+                loop.quit();
+                return;
+            }
+            conn->setZeroCopyThreshold(threshold);
+            startCpu = cpuSeconds();
+            start = std::chrono::steady_clock::now();
+            // 所有分片引用同一份数据，发送队列中只保存引用
+            for (size_t sent = 0; sent < totalBytes; sent += chunkBytes)
+            {
+                conn->send(chunk);
+            }
+            conn->shutdown();
+        });
+    server.setMessageCallBack([](const TcpConnectionPtr &, Buffer *buf,
+                                 Timestamp) { buf->retrieveAll(); });
+    server.start();
+    loop.loop();
+
+    double cpu = cpuSeconds() - startCpu;
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    ::waitpid(pid, nullptr, 0);
+
+    double gb = static_cast<double>(totalBytes) / (1024 * 1024 * 1024);
+    fprintf(stderr, "%-9s: %.3f cpu-sec/GB, %.1f MB/s\n",
+            threshold > 0 ? "zerocopy" : "copy", cpu / gb,
+            totalBytes / seconds / (1024 * 1024));
+}
+
+int main(int argc, char *argv[])
+{
+    size_t totalMB = argc > 1 ? atoi(argv[1]) : 4096;
+    size_t chunkKB = argc > 2 ? atoi(argv[2]) : 256;
+    ::signal(SIGPIPE, SIG_IGN);
+
+    runOnce(0, totalMB * 1024 * 1024, chunkKB * 1024);
+    runOnce(64 * 1024, totalMB * 1024 * 1024, chunkKB * 1024);
+
+    return 0;
+}
@@ -15,6 +15,8 @@ class Acceptor
 public:
     using NewConnectionCallBack = std::function<void(int, const InetAddress &)>;
     Acceptor(EventLoop *loop, const InetAddress &listenAddr, bool resuseport);
+    // 接管一个已经bind好的监听fd（如热升级时从旧进程继承的fd），不再bind
+    Acceptor(EventLoop *loop, int listenFd);
     ~Acceptor();
 
     void setNewConnectionCallBack(const NewConnectionCallBack &cb)
@@ -24,7 +26,14 @@ public:
 
     bool listening() const { return listening_; }
 
+    int fd() const { return acceptSocket_.fd(); }
+
+    // 监听socket已经交给其他进程共享，stop时只停止accept，不能shutdown
+    void setShared() { shared_ = true; }
+
     void listen();
+    // 停止监听，之后不再接受新连接，监听队列中还没有accept的连接会被内核重置
+    void stop();
 
 private:
     void handleRead();
@@ -34,5 +43,6 @@ private:
     Channel acceptChannel_;
     NewConnectionCallBack newConnectionCallBack_;
     bool listening_;
+    bool shared_;
 };
 } // namespace myMuduo
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Thread.h"
+#include "noncopyable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace myMuduo
+{
+/*
+    异步日志后端，双缓冲
+    前端（任意线程）只把日志追加到currentBuffer_，写满后和空闲的nextBuffer_交换，
+    后台线程定期（或者有缓冲区写满时）把写满的缓冲区整个取走，批量写入LogFile
+    磁盘跟不上时，待写的缓冲区最多积累maxBufferedBytes，超过后丢弃新的日志并计数，
+    前端永远不会等待磁盘IO
+    用法：
+        static AsyncLogging log("server", 100 * 1024 * 1024);
+        log.start();
+        Logger::instance().setOutput([](const char *msg, size_t len) { log.append(msg, len); },
+                                     [] { log.stop(); });
+    FATAL之后进程马上退出，flush用stop把已经追加的日志全部写入文件
+*/
+class AsyncLogging : noncopyable
+{
+public:
+    AsyncLogging(const std::string &basename,
+                 off_t rollSize,
+                 int flushInterval = 3,
+                 size_t maxBufferedBytes = 64 * 1024 * 1024);
+    ~AsyncLogging();
+
+    // 追加一条日志，可以在任意线程中调用，不短于一个缓冲区（4MB）的日志被丢弃
+    void append(const char *logline, size_t len);
+
+    void start();
+    // 停止后台线程，停止前写入所有已经追加的日志，重复调用时什么都不做
+    void stop();
+
+    // 因为磁盘跟不上或者单条过长而丢弃的日志条数
+    uint64_t droppedMessages() const { return totalDropped_ + dropped_; }
+
+private:
+    // 固定大小的日志缓冲区
+    class LogBuffer
+    {
+    public:
+        LogBuffer() : data_(new char[kBufferSize]), len_(0) {}
+
+        size_t avail() const { return kBufferSize - len_; }
+        void append(const char *buf, size_t len)
+        {
+            std::copy(buf, buf + len, data_.get() + len_);
+            len_ += len;
+        }
+        const char *data() const { return data_.get(); }
+        size_t length() const { return len_; }
+        void reset() { len_ = 0; }
+
+    private:
+        std::unique_ptr<char[]> data_;
+        size_t len_;
+    };
+
+    using BufferPtr = std::unique_ptr<LogBuffer>;
+    using BufferVector = std::vector<BufferPtr>;
+
+    static constexpr size_t kBufferSize = 4 * 1024 * 1024;
+
+    void threadFunc();
+
+    const std::string basename_;
+    const off_t rollSize_;
+    const int flushInterval_;
+    const size_t maxBuffers_; // 待写缓冲区个数的上限
+
+    std::atomic_bool running_;
+    Thread thread_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    BufferPtr currentBuffer_; // 前端正在写的缓冲区
+    BufferPtr nextBuffer_;    // 预备的空缓冲区
+    BufferVector buffers_;    // 写满了、等待后台线程写入文件的缓冲区
+    std::atomic<uint64_t> dropped_; // 上一次写文件之后丢弃的条数
+    std::atomic<uint64_t> totalDropped_;
+};
+} // namespace myMuduo
@@ -0,0 +1,277 @@
+#pragma once
+
+#include "Logger.h"
+#include "Thread.h"
+#include "noncopyable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <sys/types.h>
+#include <time.h>
+#include <type_traits>
+#include <vector>
+
+namespace myMuduo
+{
+/*
+    热路径上的二进制日志（延迟格式化）
+    调用点只记录格式串的编号和原始参数，写进本线程的单生产者单消费者无锁环形缓冲区，
+    不调用snprintf、不加锁；后台线程批量取走记录，然后
+        startText：在后台线程格式化成文本，交给OutputFunc（比如AsyncLogging::append）
+        startFile：把原始记录和格式串字典直接写进二进制文件，用decodeFile离线还原成文本
+    环形缓冲区满时丢弃记录并计数，调用点永远不会阻塞
+    参数只支持整数、浮点数、C字符串（最多记录1024字节）和指针，std::string要传c_str()
+    格式串用printf语法，编译器会检查参数类型
+    用法：
+        BinaryLog::instance().startText([&](const char *msg, size_t len) { asyncLog.append(msg, len); });
+        LOG_DEBUG_BIN("fd=%d revents=%d", fd, revents);
+*/
+#define LOG_BIN(level, logmsgFormat, ...)                                      \
+    do                                                                         \
+    {                                                                          \
+        if ((level) >= MYMUDUO_MIN_LOG_LEVEL &&                                \
+            myMuduo::BinaryLog::enabled(level))                                \
+        {                                                                      \
+            static const uint32_t myMuduoFormatId =                            \
+                myMuduo::BinaryLog::registerFormat(level, logmsgFormat,        \
+                                                   __FILE__, __LINE__);        \
+            if (false)                                                         \
+            {                                                                  \
+                myMuduo::BinaryLog::checkFormat(logmsgFormat, ##__VA_ARGS__);  \
+            }                                                                  \
+            myMuduo::BinaryLog::record(myMuduoFormatId, ##__VA_ARGS__);        \
+        }                                                                      \
+    } while (0)
+
+#define LOG_DEBUG_BIN(logmsgFormat, ...)                                       \
+    LOG_BIN(myMuduo::DEBUG, logmsgFormat, ##__VA_ARGS__)
+#define LOG_INFO_BIN(logmsgFormat, ...)                                        \
+    LOG_BIN(myMuduo::INFO, logmsgFormat, ##__VA_ARGS__)
+#define LOG_ERROR_BIN(logmsgFormat, ...)                                       \
+    LOG_BIN(myMuduo::ERROR, logmsgFormat, ##__VA_ARGS__)
+
+class BinaryLog : noncopyable
+{
+public:
+    using OutputFunc = Logger::OutputFunc;
+
+    static BinaryLog &instance();
+    ~BinaryLog();
+
+    // 启动后台线程，二选一；启动之前LOG_BIN什么都不做
+    void startText(OutputFunc output);
+    bool startFile(const std::string &path);
+    // 取走所有线程中剩余的记录后停止后台线程
+    void stop();
+
+    // 因为环形缓冲区满而丢弃的记录条数
+    uint64_t droppedRecords() const;
+
+    // 把startFile写出的二进制文件还原成文本，返回还原的记录条数，文件损坏返回-1
+    static long decodeFile(const std::string &path, OutputFunc output);
+
+    static bool enabled(LogLevel level)
+    {
+        return running_.load(std::memory_order_relaxed) &&
+               Logger::enabled(level);
+    }
+
+    // 每个调用点只在第一次执行时注册一次
+    static uint32_t registerFormat(LogLevel level, const char *fmt,
+                                   const char *file, int line);
+
+    // 从不调用，只让编译器按printf检查格式串和参数
+    static void checkFormat(const char *, ...)
+        __attribute__((format(printf, 1, 2)))
+    {
+    }
+
+    template <typename... Args>
+    static void record(uint32_t formatId, const Args &...args);
+
+private:
+    // 每条记录的头部，记录按8字节对齐
+    struct RecordHeader
+    {
+        uint32_t formatId;
+        uint32_t length; // 包括头部
+        int64_t nanoSecondsSinceEpoch;
+    };
+
+    // 参数的类型标记，每个参数编码为 1字节标记 + 值
+    enum ArgType : uint8_t
+    {
+        kInt,     // int64_t
+        kUint,    // uint64_t
+        kDouble,  // double
+        kString,  // uint32_t长度 + 字节
+        kPointer, // uint64_t
+    };
+
+    // 单生产者（所属线程）单消费者（后台线程）的环形缓冲区
+    struct ThreadRing
+    {
+        static constexpr size_t kSize = 1024 * 1024;
+
+        // 预留n个字节（n是8的倍数），末尾放不下时写一个填充标记后从头开始
+        // 空间不够返回nullptr
+        char *beginWrite(size_t n);
+        void commit() { head.store(pending, std::memory_order_release); }
+
+        alignas(64) std::atomic<uint64_t> head{0}; // 生产者写到的位置
+        uint64_t pending = 0;
+        uint64_t cachedTail = 0; // 生产者看到的tail，减少读共享变量
+        alignas(64) std::atomic<uint64_t> tail{0}; // 消费者读到的位置
+        std::atomic<uint64_t> dropped{0};
+        std::atomic_bool retired{false}; // 线程已退出，取完后可以释放
+        char data[kSize];
+    };
+
+    struct FormatInfo
+    {
+        LogLevel level;
+        int line;
+        const char *fmt;
+        const char *file;
+    };
+
+    static constexpr uint32_t kPadding = 0xffffffff;
+    static constexpr uint32_t kDictionary = 0xfffffffe; // 文件中的格式串字典项
+    static constexpr size_t kMaxStringArg = 1024;
+
+    BinaryLog();
+
+    static ThreadRing *threadRing()
+    {
+        if (__builtin_expect(t_ring == nullptr, 0))
+        {
+            createThreadRing();
+        }
+        return t_ring;
+    }
+    static void createThreadRing();
+
+    template <typename T> static size_t argSize(const T &arg);
+    template <typename T> static void encodeArg(char *&p, const T &arg);
+
+    void threadFunc();
+    // 取走所有线程中已提交的记录，返回取到的条数
+    size_t drain();
+    void consume(const char *record, const RecordHeader &header);
+    void writeDictionary(uint32_t formatId, const FormatInfo &info);
+    const FormatInfo *lookupFormat(uint32_t formatId);
+
+    // 把一条记录的参数[args, end)按格式串还原，以 [级别]时间 : 消息\n 追加到out
+    static void formatRecord(const FormatInfo &info, const RecordHeader &header,
+                             const char *args, const char *end,
+                             std::string *out);
+
+    static thread_local ThreadRing *t_ring;
+    static std::atomic_bool running_;
+
+    mutable std::mutex mutex_; // 保护formats_和rings_
+    std::vector<FormatInfo> formats_;
+    std::vector<ThreadRing *> rings_;
+
+    // 以下只在后台线程中使用
+    OutputFunc output_;
+    FILE *file_;
+    std::vector<FormatInfo> cachedFormats_; // formats_的副本，避免每条记录都加锁
+    std::vector<bool> written_;             // 已经写进文件的字典项
+    std::string line_;
+
+    std::atomic<uint64_t> retiredDropped_; // 已经释放的环形缓冲区丢弃的条数
+
+    std::atomic_bool stopping_;
+    std::unique_ptr<Thread> thread_;
+};
+
+template <typename T> size_t BinaryLog::argSize(const T &arg)
+{
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, const char *> || std::is_same_v<U, char *>)
+    {
+        return 1 + sizeof(uint32_t) + std::min(::strlen(arg), kMaxStringArg);
+    }
+    else
+    {
+        static_assert(std::is_arithmetic_v<U> || std::is_enum_v<U> ||
+                          std::is_pointer_v<U>,
+                      "LOG_BIN only supports numbers, strings and pointers");
+        return 1 + sizeof(uint64_t);
+    }
+}
+
+template <typename T> void BinaryLog::encodeArg(char *&p, const T &arg)
+{
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, const char *> || std::is_same_v<U, char *>)
+    {
+        uint32_t len =
+            static_cast<uint32_t>(std::min(::strlen(arg), kMaxStringArg));
+        *p++ = kString;
+        ::memcpy(p, &len, sizeof len);
+        p += sizeof len;
+        ::memcpy(p, arg, len);
+        p += len;
+    }
+    else
+    {
+        uint8_t type;
+        uint64_t value;
+        if constexpr (std::is_floating_point_v<U>)
+        {
+            type = kDouble;
+            double d = static_cast<double>(arg);
+            ::memcpy(&value, &d, sizeof value);
+        }
+        else if constexpr (std::is_pointer_v<U>)
+        {
+            type = kPointer;
+            value = reinterpret_cast<uintptr_t>(arg);
+        }
+        else if constexpr (std::is_enum_v<U> || std::is_signed_v<U>)
+        {
+            type = kInt;
+            value = static_cast<uint64_t>(static_cast<int64_t>(arg));
+        }
+        else
+        {
+            type = kUint;
+            value = static_cast<uint64_t>(arg);
+        }
+        *p++ = type;
+        ::memcpy(p, &value, sizeof value);
+        p += sizeof value;
+    }
+}
+
+template <typename... Args>
+void BinaryLog::record(uint32_t formatId, const Args &...args)
+{
+    size_t n = sizeof(RecordHeader) + (argSize(args) + ... + 0);
+    n = (n + 7) & ~static_cast<size_t>(7);
+
+    ThreadRing *ring = threadRing();
+    char *p = ring->beginWrite(n);
+    if (p == nullptr)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    RecordHeader header{formatId, static_cast<uint32_t>(n),
+                        ts.tv_sec * 1000000000LL + ts.tv_nsec};
+    ::memcpy(p, &header, sizeof header);
+    p += sizeof header;
+    (encodeArg(p, args), ...);
+    ring->commit();
+}
+} // namespace myMuduo
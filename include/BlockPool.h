@@ -0,0 +1,113 @@
+#pragma once
+
+#include "CurrentThread.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stddef.h>
+#include <unordered_map>
+#include <vector>
+
+namespace myMuduo
+{
+/*
+    按大小缓存空闲内存块的对象池
+    每个EventLoop持有一个，用来分配该loop上建立的TcpConnection，
+    连接频繁建立断开时复用已经释放的内存，不用每次都走malloc/free
+    池子属于创建它的线程（loop线程）：
+        所属线程分配和释放都只操作本地的空闲链表，不加锁
+        其他线程（如别的线程持有连接的最后一个引用）释放时放入加锁的远程队列，
+        所属线程本地链表为空时一次取走整个远程队列
+        其他线程分配时不使用缓存，直接向系统申请
+*/
+class BlockPool : noncopyable
+{
+public:
+    explicit BlockPool(size_t maxCachedBlocks = kDefaultMaxCachedBlocks);
+    ~BlockPool();
+
+    // 优先从大小为size的空闲块中取，没有时才向系统申请
+    void *allocate(size_t size);
+    // 空闲块超过上限时直接还给系统，避免连接风暴过后一直占着内存
+    void deallocate(void *p, size_t size);
+
+    // 当前缓存的空闲块个数，可以在任意线程中调用
+    size_t cachedBlocks() const;
+
+private:
+    static constexpr size_t kDefaultMaxCachedBlocks = 4096;
+
+    struct RemoteBlock
+    {
+        void *p;
+        size_t size;
+    };
+
+    bool isOwnerThread() const { return CurrentThread::tid() == ownerTid_; }
+    // 把其他线程归还的块移到本地空闲链表，只在所属线程中调用
+    void drainRemote();
+
+    const size_t maxCachedBlocks_;
+    const int ownerTid_;
+
+    // 只在所属线程中访问
+    std::unordered_map<size_t, std::vector<void *>> freeLists_;
+    std::atomic<size_t> localBlocks_;
+
+    mutable std::mutex mutex_;
+    std::vector<RemoteBlock> remoteFree_;  // 由mutex_保护
+    std::atomic<size_t> remoteBlocks_;     // 不加锁判断远程队列是否为空
+};
+
+/*
+    从BlockPool分配内存的分配器，配合std::allocate_shared使用，
+    对象和shared_ptr的控制块在同一块内存中，只需要分配一次
+    分配器持有BlockPool的引用计数，池子会活到最后一个对象释放之后
+*/
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                  "PoolAllocator only supports default new alignment");
+
+    explicit PoolAllocator(std::shared_ptr<BlockPool> pool)
+        : pool_(std::move(pool))
+    {
+    }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &other) : pool_(other.pool_)
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(pool_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) { pool_->deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &other) const
+    {
+        return pool_ == other.pool_;
+    }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &other) const
+    {
+        return pool_ != other.pool_;
+    }
+
+private:
+    template <typename U>
+    friend class PoolAllocator;
+
+    std::shared_ptr<BlockPool> pool_;
+};
+} // namespace myMuduo
@@ -15,18 +15,34 @@ public:
     static const size_t kCheapPrepend = 8;   // 记录数据包的长度
     static const size_t kInitialSize = 1024; // 缓冲区大小
 
+    // initialSize为0时不分配内存，第一次写入数据时才分配，
+    // 超过kInitialSize的部分在数据全部取走后释放，适合大量空闲连接
     explicit Buffer(size_t initialSize = kInitialSize)
-        : buffer_(kCheapPrepend + initialSize), readerIndex_(kCheapPrepend),
-          writerIndex_(kCheapPrepend)
+        : buffer_(initialSize > 0 ? kCheapPrepend + initialSize : 0),
+          readerIndex_(kCheapPrepend), writerIndex_(kCheapPrepend),
+          lazy_(initialSize == 0)
     {
     }
 
     size_t readableBytes() const { return writerIndex_ - readerIndex_; }
 
-    size_t writableBytes() const { return buffer_.size() - writerIndex_; }
+    size_t writableBytes() const
+    {
+        return buffer_.size() > writerIndex_ ? buffer_.size() - writerIndex_
+                                             : 0;
+    }
 
     size_t prependableBytes() const { return readerIndex_; }
 
+    // 交换两个缓冲区的内容，只交换内部指针，不拷贝数据
+    void swap(Buffer &rhs)
+    {
+        buffer_.swap(rhs.buffer_);
+        std::swap(readerIndex_, rhs.readerIndex_);
+        std::swap(writerIndex_, rhs.writerIndex_);
+        std::swap(lazy_, rhs.lazy_);
+    }
+
     // 返回缓冲区中可读数据的起始地址
     const char *peek() const { return begin() + readerIndex_; }
 
@@ -52,7 +68,16 @@ public:
         }
     }
 
-    void retrieveAll() { readerIndex_ = writerIndex_ = kCheapPrepend; }
+    void retrieveAll()
+    {
+        readerIndex_ = writerIndex_ = kCheapPrepend;
+        // 大消息撑大的内存在取空后释放，空闲连接不会一直占着；
+        // 不超过kInitialSize的留给下一条消息，避免每条消息都malloc/free
+        if (lazy_ && buffer_.size() > kCheapPrepend + kInitialSize)
+        {
+            std::vector<char>().swap(buffer_);
+        }
+    }
 
     // 将onMessage函数上报的buffer数据，转为string类型的数据返回
     std::string retrieveAllAsString()
@@ -88,6 +113,15 @@ public:
         writerIndex_ += len;
     }
 
+    // 在可读数据之前写入data（如消息长度），len不能超过prependableBytes()
+    // 默认预留的kCheapPrepend字节可以放下最长8字节的头部，不需要移动已有数据
+    void prepend(const void *data, size_t len)
+    {
+        readerIndex_ -= len;
+        const char *d = static_cast<const char *>(data);
+        std::copy(d, d + len, begin() + readerIndex_);
+    }
+
     // 从fd上读取数据
     ssize_t readFd(int fd, int *saveErrno);
 
@@ -95,8 +129,8 @@ public:
     ssize_t writeFd(int fd, int *saveErrno);
 
 private:
-    char *begin() { return &*buffer_.begin(); }
-    const char *begin() const { return &*buffer_.begin(); }
+    char *begin() { return buffer_.data(); }
+    const char *begin() const { return buffer_.data(); }
     void makeSpace(size_t len)
     {
         // 总空间不足（含头部预留）
@@ -118,6 +152,7 @@ private:
     std::vector<char> buffer_;
     size_t readerIndex_;
     size_t writerIndex_;
+    bool lazy_; // 按需分配，取空后释放超过kInitialSize的内存
 };
 
 } // namespace myMuduo
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <functional>
 #include <memory>
+#include <stddef.h>
+#include <string>
 
 namespace myMuduo
 {
@@ -17,4 +19,24 @@ using MessageCallBack =
     std::function<void(const TcpConnectionPtr &, Buffer *, Timestamp)>;
 using HighWaterMarkCallBack =
     std::function<void(const TcpConnectionPtr &, size_t)>;
+using LowWaterMarkCallBack =
+    std::function<void(const TcpConnectionPtr &, size_t)>;
+
+/*
+    连接的回调表，同一个TcpServer的所有连接共享一份，每个连接只保存一个shared_ptr，
+    不再为每个连接拷贝一遍所有的std::function
+    TcpConnection上单独设置回调时会先拷贝一份，不影响共享同一张表的其他连接
+*/
+struct ConnectionHandlers
+{
+    std::string name; // 连接名的前缀，连接名为name#id，需要时才拼接
+    ConnectionCallBack connectionCallBack;
+    MessageCallBack messageCallBack;
+    WriteCompleteCallBack writeCompleteCallBack;
+    HighWaterMarkCallBack highWaterMarkCallBack;
+    LowWaterMarkCallBack lowWaterMarkCallBack;
+    CloseCallBack closeCallBack;
+    size_t highWaterMark = 64 * 1024 * 1024; // 发送队列高水位，默认64M
+    size_t lowWaterMark = 0;                 // 发送队列低水位
+};
 } // namespace myMuduo
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "InetAddress.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace myMuduo
+{
+class Channel;
+class EventLoop;
+
+/*
+    主动发起连接：非阻塞connect，在loop中等待socket可写，用SO_ERROR判断连接结果
+    连接失败时按指数退避重试（加随机抖动，避免大量客户端同时重连），
+    连接成功后把sockfd交给NewConnectionCallBack，之后不再管理该fd
+    由TcpClient使用，必须由shared_ptr管理
+*/
+class Connector : noncopyable, public std::enable_shared_from_this<Connector>
+{
+public:
+    using NewConnectionCallBack = std::function<void(int sockfd)>;
+
+    Connector(EventLoop *loop, const InetAddress &serverAddr);
+    ~Connector();
+
+    void setNewConnectionCallBack(const NewConnectionCallBack &cb)
+    {
+        newConnectionCallBack_ = cb;
+    }
+
+    const InetAddress &serverAddress() const { return serverAddr_; }
+
+    // 可以在任意线程中调用
+    void start();
+    // 只能在loop线程中调用，连接断开后重新连接，退避时间从头开始
+    void restart();
+    // 可以在任意线程中调用，停止正在进行的连接和重试
+    void stop();
+
+private:
+    enum States
+    {
+        kDisconnected,
+        kConnecting,
+        kConnected
+    };
+    static constexpr double kInitRetryDelay = 0.5; // 秒
+    static constexpr double kMaxRetryDelay = 30.0;
+
+    void setState(States s) { state_ = s; }
+    void startInLoop();
+    void stopInLoop();
+    void connect();
+    void connecting(int sockfd);
+    void handleWrite();
+    void handleError();
+    void retry(int sockfd);
+    int removeAndResetChannel();
+
+    EventLoop *loop_;
+    InetAddress serverAddr_;
+    std::atomic_bool connect_; // 用户是否希望保持连接
+    States state_;
+    std::unique_ptr<Channel> channel_; // 只在connect进行中存在
+    NewConnectionCallBack newConnectionCallBack_;
+    double retryDelay_;
+};
+} // namespace myMuduo
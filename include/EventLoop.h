@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BlockPool.h"
 #include "CurrentThread.h"
 #include "Timestamp.h"
 #include "noncopyable.h"
@@ -14,6 +15,7 @@ namespace myMuduo
 {
 class Channel;
 class Poller;
+class TimerQueue;
 
 // 事件循环类
 // 主要包含两个模块 Channel(发生的事件)    Poller(epoll的抽象)
@@ -30,12 +32,21 @@ public:
     // 退出事件循环
     void quit();
 
+    // 本轮poll返回的时间，每次poll返回时刷新一次
+    // 同一轮中的回调用它代替Timestamp::now()，不必每次都读时钟
     Timestamp pollReturnTime() const { return pollReturnTime_; }
 
     // 在当前loop中执行
     void runInLoop(Functor cb);
     // 把cb放入队列中，唤醒loop所在的线程，执行cb
     void queueInLoop(Functor cb);
+    // 在本轮循环的最后（doPendingFunctors之后）执行cb，只能在loop线程中调用
+    // 用于把同一轮循环中的多次操作合并成一次，如TcpConnection的auto cork
+    // 在这些回调中再注册的cb会在下一轮循环的最后执行，且不会唤醒loop
+    void runAtIterationEnd(Functor cb);
+
+    // seconds秒之后在loop线程中执行cb，可以在任意线程中调用
+    void runAfter(double seconds, Functor cb);
 
     // 唤醒loop所在的线程
     void wakeup();
@@ -47,12 +58,33 @@ public:
 
     // 判断EventLoop对象是否在自己的线程里面
     bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
+    // 只能在loop线程中调用的函数（Channel/Poller的修改等）用它检查，
+    // 在其他线程调用时直接终止进程，定义NDEBUG时为空
+    void assertInLoopThread() const
+    {
+#ifndef NDEBUG
+        if (!isInLoopThread())
+        {
+            abortNotInLoopThread();
+        }
+#endif
+    }
+
+    // 在该loop线程中建立的TcpConnection的对象池，可以在任意线程中使用，
+    // 在loop线程中分配和释放时不加锁
+    const std::shared_ptr<BlockPool> &connectionPool() const
+    {
+        return connectionPool_;
+    }
 
 private:
+    void abortNotInLoopThread() const;
     // 处理wake up
     void handleRead();
     // 执行回调
     void doPendingFunctors();
+    // 执行本轮循环结束时的回调
+    void doIterationEndFunctors();
 
     using ChannelList = std::vector<Channel *>;
 
@@ -62,9 +94,11 @@ private:
         threadId_; // 记录当前loop所在线程id，创建时初始化，后续不更改，只需要和当前threadid对比，即可判断
     Timestamp pollReturnTime_;       // poller返回发生事件的channels的时间点
     std::unique_ptr<Poller> poller_; // 包含的poller
+    std::shared_ptr<BlockPool> connectionPool_; // TcpConnection的对象池
 
     int wakeupFd_; // 作用：当mainLoop获取一个新用户的channel，通过轮询算法选择一个subloop，通过该成员唤醒subloop处理channel
     std::unique_ptr<Channel> wakeupChannel_;
+    std::unique_ptr<TimerQueue> timerQueue_; // 定时器，同样通过一个fd注册到poller
 
     ChannelList activateChannels_;
 
@@ -72,5 +106,7 @@ private:
         callingPendingFunctors_; // 标识当前loop是否有需要执行的回调操作
     std::vector<Functor> pendingFunctors_; // 存储loop需要执行的所有回调操作
     std::mutex mutex_; // 互斥锁，用来保护上面vector容器的线程安全操作
+    std::vector<Functor>
+        iterationEndFunctors_; // 本轮循环结束时执行的回调，只在loop线程中访问，不需要加锁
 };
 } // namespace myMuduo
\ No newline at end of file
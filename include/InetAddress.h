@@ -3,28 +3,54 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 namespace myMuduo
 {
-// 封装socket地址类型
+// 封装socket地址类型，支持IPv4、IPv6和Unix域socket
 class InetAddress
 {
 public:
+    // toIpPort/formatTo输出的最大长度（含结尾的'\0'）
+    static constexpr size_t kMaxStringLength = sizeof(sockaddr_un::sun_path) + 8;
+
+    // ip中含有':'时按IPv6地址解析，不是合法的地址时LOG_FATAL，不会退化成ANY
     explicit InetAddress(uint16_t port = 0, std::string ip = "127.0.0.1");
 
-    explicit InetAddress(const sockaddr_in &addr) : addr_(addr) {}
+    explicit InetAddress(const sockaddr_in &addr);
+    explicit InetAddress(const sockaddr_in6 &addr);
+    // 从内核返回的地址（accept、getsockname、recvmmsg等）构造
+    InetAddress(const sockaddr *addr, socklen_t len);
+
+    // Unix域socket地址，以'@'开头时使用Linux的抽象命名空间，不在文件系统中创建文件
+    // 路径不能超过sun_path的长度（含结尾的'\0'），否则LOG_FATAL
+    static InetAddress fromUnixPath(const std::string &path);
+
+    sa_family_t family() const { return addr_.ss_family; }
+    bool isUnix() const { return family() == AF_UNIX; }
 
     std::string toIp() const;
 
+    // IPv4为ip:port，IPv6为[ip]:port，Unix域socket为unix:路径
     std::string toIpPort() const;
+    // 把toIpPort的结果写入buf，返回写入的长度，不分配内存，size至少为kMaxStringLength时不会截断
+    size_t formatTo(char *buf, size_t size) const;
 
+    // Unix域socket返回0
     uint16_t toPort() const;
 
-    const sockaddr_in *getSockAddr() const { return &addr_; }
+    const sockaddr *getSockAddr() const
+    {
+        return reinterpret_cast<const sockaddr *>(&addr_);
+    }
+    // 传给bind/connect/sendmsg的地址长度
+    socklen_t getSockLen() const { return len_; }
 
-    void setSockAddr(const sockaddr_in &addr) { addr_ = addr; }
+    void setSockAddr(const sockaddr *addr, socklen_t len);
 
 private:
-    sockaddr_in addr_;
+    sockaddr_storage addr_;
+    socklen_t len_;
 };
-} // namespace myMuduo
\ No newline at end of file
+} // namespace myMuduo
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Buffer.h"
+#include "CallBack.h"
+#include "Timestamp.h"
+#include "noncopyable.h"
+
+#include <functional>
+#include <stdint.h>
+#include <string_view>
+
+namespace myMuduo
+{
+/*
+    长度前缀的消息编解码：每条消息前面是消息体的长度，
+    长度为2/4/8字节的大端整数，或者varint（LEB128，每字节低7位有效，最高位表示后面还有字节）
+        接收：把onMessage设为TcpServer/TcpClient的MessageCallBack，在输入缓冲区中原地解析，
+              完整的消息以string_view交给FrameCallBack，不拷贝；一次读到的多条消息在一轮中依次回调，
+              最后统一retrieve
+        发送：send(conn, Buffer *)把头部写入Buffer预留的kCheapPrepend空间，
+              send(conn, string_view)用sendv把头部和消息体一次写出，都不拷贝消息体
+    消息长度超过maxFrameSize（不超过头部能表示的最大长度）时认为对端出错，
+    回调ErrorCallBack，默认记录日志并关闭连接
+*/
+class LengthHeaderCodec : noncopyable
+{
+public:
+    enum HeaderType
+    {
+        kVarint = 0,
+        kFixed16 = 2,
+        kFixed32 = 4,
+        kFixed64 = 8,
+    };
+
+    // frame指向连接的输入缓冲区，只在回调期间有效
+    using FrameCallBack = std::function<void(
+        const TcpConnectionPtr &conn, std::string_view frame, Timestamp)>;
+    using ErrorCallBack =
+        std::function<void(const TcpConnectionPtr &conn, const char *reason)>;
+
+    static constexpr size_t kDefaultMaxFrameSize = 64 * 1024 * 1024;
+    // varint头部的最大长度，64位整数需要10个字节
+    static constexpr size_t kMaxHeaderLength = 10;
+
+    explicit LengthHeaderCodec(FrameCallBack cb,
+                               HeaderType type = kFixed32,
+                               size_t maxFrameSize = kDefaultMaxFrameSize);
+
+    void setErrorCallBack(ErrorCallBack cb) { errorCallBack_ = std::move(cb); }
+
+    HeaderType headerType() const { return type_; }
+    size_t maxFrameSize() const { return maxFrameSize_; }
+
+    void onMessage(const TcpConnectionPtr &conn,
+                   Buffer *buf,
+                   Timestamp receiveTime);
+
+    // 发送buf中的全部可读数据作为一条消息，成功时buf被清空
+    // 各个发送函数在消息长度超过maxFrameSize时记录日志并返回false，不发送任何数据
+    bool send(const TcpConnectionPtr &conn, Buffer *buf) const;
+    bool send(const TcpConnectionPtr &conn, std::string_view frame) const;
+    // 把一条消息（头部 + 消息体）追加到out中，多条消息攒在一起之后再一次send(Buffer *)
+    bool appendFrame(Buffer *out, std::string_view frame) const;
+
+    // 把长度编码到out中，返回头部的字节数，out至少有kMaxHeaderLength字节，
+    // frameLen不能超过maxFrameSize
+    size_t encodeHeader(char *out, uint64_t frameLen) const;
+
+private:
+    // 从data开头解析头部，成功时返回头部长度并写入frameLen，数据不够返回0，格式错误返回-1
+    int decodeHeader(const char *data, size_t len, uint64_t *frameLen) const;
+    // 发送前检查消息长度，超过maxFrameSize时记录日志
+    bool checkFrameSize(size_t frameLen) const;
+
+    FrameCallBack frameCallBack_;
+    ErrorCallBack errorCallBack_;
+    const HeaderType type_;
+    const size_t maxFrameSize_;
+};
+} // namespace myMuduo
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Channel.h"
+#include "noncopyable.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace myMuduo
+{
+class EventLoop;
+
+/*
+    热升级时把监听socket交给新进程
+    旧进程在Unix域socket path上等待，新进程连接上来后通过SCM_RIGHTS把监听fd发过去，
+    两个进程共享同一个监听socket，新进程开始accept后旧进程再停止监听并排空已有连接，
+    整个过程中端口一直处于LISTEN状态，不会有连接被拒绝
+    只接受和当前进程同一个用户的进程的请求
+*/
+class ListenSocketHandoff : noncopyable
+{
+public:
+    using HandoffCallBack = std::function<void()>;
+
+    ListenSocketHandoff(EventLoop *loop, const std::string &path, int listenFd);
+    ~ListenSocketHandoff();
+
+    // 监听fd发送给新进程之后回调，一般在回调中调用TcpServer::stop排空连接
+    void setHandoffCallBack(HandoffCallBack cb) { handoffCallBack_ = std::move(cb); }
+
+    // 在path上开始等待新进程
+    void start();
+
+    // 新进程调用：连接path上的旧进程，取得监听fd，没有旧进程或者失败时返回-1
+    static int receive(const std::string &path);
+
+private:
+    void handleRead();
+
+    EventLoop *loop_;
+    const std::string path_;
+    const int listenFd_; // 要交出去的监听fd，不属于本对象
+    int handoffFd_;      // 在path上监听的Unix域socket
+    std::unique_ptr<Channel> channel_;
+    HandoffCallBack handoffCallBack_;
+};
+} // namespace myMuduo
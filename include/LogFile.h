@@ -0,0 +1,48 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <stdio.h>
+#include <string>
+#include <sys/types.h>
+#include <time.h>
+
+namespace myMuduo
+{
+/*
+    日志文件，按大小和日期滚动
+    文件名为 basename.年月日-时分秒.主机名.pid.log
+    只由AsyncLogging的后台线程使用，不是线程安全的
+*/
+class LogFile : noncopyable
+{
+public:
+    LogFile(const std::string &basename, off_t rollSize, int flushInterval = 3);
+    ~LogFile();
+
+    void append(const char *logline, size_t len);
+    void flush();
+
+private:
+    // 关闭当前文件，打开一个新文件
+    void rollFile();
+    static std::string logFileName(const std::string &basename, time_t now);
+
+    // 每写入这么多次检查一次是否需要按日期滚动或者flush，避免每次都调用time
+    static const int kCheckTimeRoll = 1024;
+    static const int kRollPerSeconds = 60 * 60 * 24;
+
+    const std::string basename_;
+    const off_t rollSize_;    // 文件写满这么多字节后滚动
+    const int flushInterval_; // flush的间隔（秒）
+
+    FILE *fp_;
+    char buffer_[64 * 1024]; // fp_的用户态缓冲区，减少write调用
+    off_t writtenBytes_;
+    int count_;
+
+    time_t startOfPeriod_; // 当前文件所属的那一天的0点
+    time_t lastRoll_;
+    time_t lastFlush_;
+};
+} // namespace myMuduo
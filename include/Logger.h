@@ -1,82 +1,141 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string>
 
 #include "noncopyable.h"
 
-// 定义日志级别 INFO ERROR FATAL DEBUG
+// 定义日志级别 DEBUG INFO ERROR FATAL
 namespace myMuduo
 {
-// 定义宏打印信息
-#define LOG_INFO(logmsgFormat, ...)                                            \
+/*
+    编译期的最低日志级别，低于它的LOG_*调用在预处理阶段就被整个删掉，连参数都不会求值
+    默认只有定义了MUDEBUG才保留LOG_DEBUG；也可以直接 -DMYMUDUO_MIN_LOG_LEVEL=2 只保留ERROR和FATAL
+    数值和LogLevel一致：0 DEBUG，1 INFO，2 ERROR，3 FATAL（FATAL总是保留）
+    被删掉的调用展开成if (0)中的snprintf：参数不求值也不生成代码，但仍然检查格式和参数类型，
+    只在日志中使用的变量也不会报unused
+*/
+#ifndef MYMUDUO_MIN_LOG_LEVEL
+#ifdef MUDEBUG
+#define MYMUDUO_MIN_LOG_LEVEL 0
+#else
+#define MYMUDUO_MIN_LOG_LEVEL 1
+#endif
+#endif
+
+// 先检查运行期的级别，通过了才格式化，级别作为参数传给log，不修改Logger的状态
+#define MYMUDUO_LOG(level, logmsgFormat, ...)                                  \
     do                                                                         \
     {                                                                          \
-        Logger &logger = Logger::instance();                                   \
-        logger.setLogLevel(INFO);                                              \
-        char buf[1024] = {0};                                                  \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__);                      \
-        logger.log(buf);                                                       \
+        if (myMuduo::Logger::enabled(level))                                   \
+        {                                                                      \
+            char buf[1024];                                                    \
+            snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__);                  \
+            myMuduo::Logger::instance().log(level, buf);                       \
+        }                                                                      \
     } while (0)
 
-#define LOG_ERROR(logmsgFormat, ...)                                           \
+// 编译期被删掉的日志调用
+#define MYMUDUO_LOG_DISABLED(logmsgFormat, ...)                                \
     do                                                                         \
     {                                                                          \
-        Logger &logger = Logger::instance();                                   \
-        logger.setLogLevel(ERROR);                                             \
-        char buf[1024] = {0};                                                  \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__);                      \
-        logger.log(buf);                                                       \
+        if (0)                                                                 \
+        {                                                                      \
+            snprintf(nullptr, 0, logmsgFormat, ##__VA_ARGS__);                 \
+        }                                                                      \
     } while (0)
 
+// 定义宏打印信息
+#if MYMUDUO_MIN_LOG_LEVEL <= 1
+#define LOG_INFO(logmsgFormat, ...)                                            \
+    MYMUDUO_LOG(myMuduo::INFO, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_INFO(logmsgFormat, ...)                                            \
+    MYMUDUO_LOG_DISABLED(logmsgFormat, ##__VA_ARGS__)
+#endif
+
+#if MYMUDUO_MIN_LOG_LEVEL <= 2
+#define LOG_ERROR(logmsgFormat, ...)                                           \
+    MYMUDUO_LOG(myMuduo::ERROR, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(logmsgFormat, ...)                                           \
+    MYMUDUO_LOG_DISABLED(logmsgFormat, ##__VA_ARGS__)
+#endif
+
+// FATAL不受级别限制，写完日志后退出进程
 #define LOG_FATAL(logmsgFormat, ...)                                           \
     do                                                                         \
     {                                                                          \
-        Logger &logger = Logger::instance();                                   \
-        logger.setLogLevel(FATAL);                                             \
-        char buf[1024] = {0};                                                  \
+        char buf[1024];                                                        \
         snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__);                      \
-        logger.log(buf);                                                       \
+        myMuduo::Logger::instance().log(myMuduo::FATAL, buf);                  \
         exit(-1);                                                              \
     } while (0)
 
-#ifdef MUDEBUG
+#if MYMUDUO_MIN_LOG_LEVEL <= 0
 #define LOG_DEBUG(logmsgFormat, ...)                                           \
-    do                                                                         \
-    {                                                                          \
-        Logger &logger = Logger::instance();                                   \
-        logger.setLogLevel(DEBUG);                                             \
-        char buf[1024] = {0};                                                  \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__);                      \
-        logger.log(buf);                                                       \
-    } while (0)
+    MYMUDUO_LOG(myMuduo::DEBUG, logmsgFormat, ##__VA_ARGS__)
 #else
-#define LOG_DEBUG(logmsgFormat, ...)
+#define LOG_DEBUG(logmsgFormat, ...)                                           \
+    MYMUDUO_LOG_DISABLED(logmsgFormat, ##__VA_ARGS__)
 #endif
 
+// 级别从低到高排列，低于最低级别的日志不输出
 enum LogLevel
 {
+    DEBUG, // 调试信息
     INFO,  // 普通信息
     ERROR, // 错误信息
-    FATAL, // core信息，无法修复
-    DEBUG  // 调试信息
+    FATAL  // core信息，无法修复
 };
 
 // 日志类
 class Logger : noncopyable
 {
 public:
+    // 日志的输出目的地，默认写到stdout，可以换成AsyncLogging::append
+    using OutputFunc = std::function<void(const char *msg, size_t len)>;
+    using FlushFunc = std::function<void()>;
+
     // 获取日志唯一的实例对象
     static Logger &instance();
 
-    // 设置日志级别
-    void setLogLevel(int level);
+    // 运行期的最低日志级别，默认INFO，可以在任意线程中随时修改
+    static void setLogLevel(LogLevel level)
+    {
+        logLevel_.store(level, std::memory_order_relaxed);
+    }
+    static LogLevel logLevel()
+    {
+        return static_cast<LogLevel>(logLevel_.load(std::memory_order_relaxed));
+    }
+    // LOG_*宏在格式化之前调用，只是一次relaxed读
+    static bool enabled(LogLevel level)
+    {
+        return level >= logLevel_.load(std::memory_order_relaxed);
+    }
+
+    // 在程序启动、还没有其他线程写日志之前设置
+    // FATAL日志写入output之后、进程退出之前调用flush，flush要把output缓冲的日志全部写出，
+    // 否则导致退出的那条日志会丢失
+    void setOutput(OutputFunc output, FlushFunc flush)
+    {
+        output_ = std::move(output);
+        flush_ = std::move(flush);
+    }
 
-    // 写日志
-    void log(const std::string &msg);
+    // 写日志，不再检查级别
+    void log(LogLevel level, const char *msg);
 
 private:
     Logger();
 
-    int logLevel_;
+    static inline std::atomic<int> logLevel_{INFO};
+
+    OutputFunc output_;
+    FlushFunc flush_;
 };
-} // namespace myMuduo
\ No newline at end of file
+} // namespace myMuduo
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+namespace myMuduo
+{
+/*
+    进程内所有TcpConnection发送队列占用内存的统计和上限
+    发送队列中拷贝和引用的数据都计入，sendfile的文件段不占用内存不计入
+*/
+class OutputBudget
+{
+public:
+    // 设置上限，0表示不限制（默认）
+    static void setLimit(size_t bytes)
+    {
+        limit_.store(bytes, std::memory_order_relaxed);
+    }
+    static size_t limit() { return limit_.load(std::memory_order_relaxed); }
+
+    // 当前所有发送队列占用的内存
+    static size_t used() { return used_.load(std::memory_order_relaxed); }
+
+    static void charge(size_t bytes)
+    {
+        used_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    static void release(size_t bytes)
+    {
+        used_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    // 是否已经超过上限
+    static bool exceeded()
+    {
+        size_t bytes = limit();
+        return bytes > 0 && used() > bytes;
+    }
+
+private:
+    static std::atomic<size_t> limit_;
+    static std::atomic<size_t> used_;
+};
+} // namespace myMuduo
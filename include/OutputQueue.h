@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Buffer.h"
+#include "SharedBuffer.h"
+#include "noncopyable.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <vector>
+
+namespace myMuduo
+{
+/*
+    TcpConnection的发送队列
+    拷贝进来的数据保存在内部的Buffer中，SharedBuffer只保存引用不拷贝，
+    文件只记录fd和偏移，发送时用sendfile直接从page cache发出
+    队列按追加顺序记录每一段数据，发送时用writev把多段数据一次写出
+*/
+class OutputQueue : noncopyable
+{
+public:
+    // 空队列不分配任何内存，适合大量空闲连接
+    OutputQueue()
+        : buffer_(0), head_(0), readableBytes_(0), memoryBytes_(0), zeroCopyThreshold_(0),
+          nextZeroCopyId_(0), pinnedBytes_(0)
+    {
+    }
+    ~OutputQueue();
+
+    // 待发送的总字节数
+    size_t readableBytes() const { return readableBytes_; }
+
+    // 待发送数据中占用内存的字节数（不包括文件段），加上零拷贝发送后等待完成通知的数据，
+    // 同时计入OutputBudget
+    size_t memoryBytes() const { return memoryBytes_ + pinnedBytes_; }
+
+    bool empty() const { return readableBytes_ == 0; }
+
+    // 拷贝[data, data + len)到队尾
+    void append(const char *data, size_t len);
+
+    // 引用buf到队尾，不拷贝数据
+    void append(const SharedBuffer &buf);
+
+    // 文件fd中[offset, offset + len)的内容追加到队尾，队列接管fd，发送完成后关闭
+    void appendFile(int fd, off_t offset, size_t len);
+
+    // 丢弃队头已经发送的len个字节
+    void retrieve(size_t len);
+
+    void retrieveAll();
+
+    // 通过fd发送队列中的数据，多段数据用writev一次写出，
+    // 队头是文件段时用sendfile发送该文件段，
+    // 队头是足够大的SharedBuffer段时用MSG_ZEROCOPY发送
+    // 文件段sendfile失败（EAGAIN除外）或者文件比给出的长度短（ENODATA）时丢弃该段并返回-1，
+    // 调用者应关闭连接
+    ssize_t writeFd(int fd, int *saveErrno);
+
+    // 长度大于等于threshold的SharedBuffer段使用MSG_ZEROCOPY发送，0表示关闭
+    // fd需要先打开SO_ZEROCOPY
+    void setZeroCopyThreshold(size_t threshold)
+    {
+        zeroCopyThreshold_ = threshold;
+    }
+    size_t zeroCopyThreshold() const { return zeroCopyThreshold_; }
+
+    // 内核通知编号为[lo, hi]的零拷贝发送已经完成，释放这些发送引用的数据，
+    // 同时从OutputBudget中扣除
+    void zeroCopyCompleted(uint32_t lo, uint32_t hi);
+
+    // 已经交给内核零拷贝发送、但还没有收到完成通知的字节数
+    size_t pinnedBytes() const { return pinnedBytes_; }
+
+private:
+    // 队列中的一段数据，file不为空时表示文件file中从offset开始的len个字节，
+    // 否则data为空时表示buffer_中接下来的len个字节
+    struct Segment
+    {
+        SharedBuffer data;
+        size_t len;
+        std::shared_ptr<int> file;
+        off_t offset;
+    };
+
+    // 一次writev最多携带的数据段个数
+    static const int kMaxIovecs = IOV_MAX;
+    // 一次sendfile最多发送的字节数，避免一个大文件长时间占用loop线程
+    static constexpr size_t kMaxFileChunk = 1024 * 1024;
+
+    // 一次零拷贝发送，完成通知到来之前必须持有它引用的数据
+    struct PinnedSend
+    {
+        uint32_t id;
+        std::vector<SharedBuffer> data;
+        size_t len;
+    };
+
+    // 队头已经发送完的段积累到这么多个之后才考虑整体前移
+    static constexpr size_t kCompactSegments = 64;
+
+    ssize_t writeZeroCopy(int fd, int *saveErrno);
+    // 丢弃已经发送完的队头段
+    void popFront();
+
+    Buffer buffer_; // 保存拷贝进来的数据
+    // 用vector加队头下标代替deque，std::deque构造时就要分配几百字节
+    std::vector<Segment> segments_;
+    size_t head_; // 第一个还没有发送完的段
+    size_t readableBytes_;
+    size_t memoryBytes_;
+
+    size_t zeroCopyThreshold_;
+    uint32_t nextZeroCopyId_; // 内核为每次成功的MSG_ZEROCOPY发送按顺序编号
+    std::vector<PinnedSend> pinned_;
+    size_t pinnedBytes_;
+};
+} // namespace myMuduo
@@ -30,6 +30,9 @@ public:
     // 判断参数channel是否在当前Poller当中
     bool hasChannel(Channel *channel) const;
 
+    // Poller的状态只能在所属loop的线程中修改
+    void assertInLoopThread() const;
+
     // EventLoop可以通过该接口获取默认的IO复用的具体实例化对象
     static Poller *newDefaultPoller(EventLoop *loop);
 
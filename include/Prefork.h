@@ -0,0 +1,49 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <functional>
+#include <sys/types.h>
+#include <time.h>
+#include <vector>
+
+namespace myMuduo
+{
+/*
+    多进程模式：master进程fork出numWorkers个worker进程，每个worker运行自己的
+    EventLoop + EventLoopThreadPool，用SO_REUSEPORT各自监听同一个端口（TcpServer::kReusePort），
+    内核把新连接分散到各个worker，进程之间不共享内存分配器和锁
+    master负责重启异常退出的worker，收到SIGTERM/SIGINT时转发SIGTERM给所有worker，
+    worker收到后应当调用TcpServer::stop排空连接再退出（见SignalWatcher）
+*/
+class Prefork : noncopyable
+{
+public:
+    // 在worker进程中执行，index为worker编号[0, numWorkers)，返回值作为worker的退出码
+    using WorkerFunc = std::function<int(int index)>;
+
+    Prefork(int numWorkers, WorkerFunc func);
+
+    // 在master进程中调用，直到所有worker都退出后才返回
+    void run();
+
+private:
+    struct Worker
+    {
+        pid_t pid;
+        time_t startTime; // 用来识别启动后立即崩溃的worker
+    };
+
+    // 异常退出的worker重启之前至少要运行这么久，否则等待一段时间再重启，避免fork风暴
+    static constexpr int kMinWorkerLifetime = 1;
+
+    void spawn(int index);
+    // 回收退出的worker，需要时重启，返回是否还有worker在运行
+    bool reap();
+
+    const int numWorkers_;
+    WorkerFunc func_;
+    std::vector<Worker> workers_;
+    bool stopping_;
+};
+} // namespace myMuduo
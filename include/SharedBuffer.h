@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace myMuduo
+{
+/*
+    不可变的、带引用计数的数据片
+    拷贝SharedBuffer只增加引用计数，不拷贝底层数据，
+    适合跨线程发送或者把同一份数据发送给多个TcpConnection
+*/
+class SharedBuffer
+{
+public:
+    SharedBuffer() : offset_(0), len_(0) {}
+
+    // 接管data的所有权，之后数据不可再修改
+    explicit SharedBuffer(std::string data)
+        : data_(std::make_shared<const std::string>(std::move(data))),
+          offset_(0), len_(data_->size())
+    {
+    }
+
+    SharedBuffer(const char *data, size_t len)
+        : SharedBuffer(std::string(data, len))
+    {
+    }
+
+    const char *data() const
+    {
+        return data_ ? data_->data() + offset_ : nullptr;
+    }
+
+    size_t size() const { return len_; }
+
+    bool empty() const { return len_ == 0; }
+
+    std::string_view view() const { return std::string_view(data(), len_); }
+
+    // 截取[offset, offset + len)，和原对象共享底层数据
+    SharedBuffer slice(size_t offset, size_t len) const
+    {
+        SharedBuffer result(*this);
+        offset = std::min(offset, len_);
+        result.offset_ += offset;
+        result.len_ = std::min(len, len_ - offset);
+        return result;
+    }
+
+    // 引用同一份底层数据的SharedBuffer个数
+    long useCount() const { return data_.use_count(); }
+
+private:
+    std::shared_ptr<const std::string> data_;
+    size_t offset_;
+    size_t len_;
+};
+} // namespace myMuduo
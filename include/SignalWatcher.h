@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Channel.h"
+#include "noncopyable.h"
+
+#include <functional>
+
+namespace myMuduo
+{
+class EventLoop;
+
+/*
+    用signalfd把信号转成loop中的读事件，回调在loop线程中执行，不受异步信号安全的限制
+    构造时会在当前线程屏蔽signo，需要在创建其他线程（如TcpServer::start）之前构造，
+    新线程继承屏蔽字，信号才不会被投递到其他线程
+*/
+class SignalWatcher : noncopyable
+{
+public:
+    using SignalCallBack = std::function<void(int signo)>;
+
+    SignalWatcher(EventLoop *loop, int signo, SignalCallBack cb);
+    ~SignalWatcher();
+
+private:
+    void handleRead();
+
+    const int signo_;
+    const int signalFd_;
+    Channel channel_;
+    SignalCallBack callback_;
+};
+} // namespace myMuduo
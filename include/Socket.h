@@ -23,9 +23,12 @@ public:
     void shutdownWrite();
 
     void setTcpNoDelay(bool on);
+    void setTcpCork(bool on);
     void setReuseAddr(bool on);
     void setReusePort(bool on);
     void setKeepAlive(bool on);
+    // 内核不支持SO_ZEROCOPY时返回false
+    bool setZeroCopy(bool on);
 
 private:
     const int sockfd_;
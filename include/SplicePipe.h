@@ -0,0 +1,42 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <sys/types.h>
+
+namespace myMuduo
+{
+/*
+    splice转发使用的管道
+    数据从一个socket splice进管道，再从管道splice到另一个socket，全程不经过用户态
+*/
+class SplicePipe : noncopyable
+{
+public:
+    SplicePipe();
+    ~SplicePipe();
+
+    // 管道是否创建成功
+    bool valid() const { return fds_[0] >= 0; }
+
+    // 管道中待写出的字节数
+    size_t readableBytes() const { return size_; }
+
+    // 管道已满时应该暂停读取源socket
+    bool full() const { return size_ >= capacity_; }
+
+    // 从fd读取数据到管道，最多读满管道
+    ssize_t readFd(int fd, int *saveErrno);
+
+    // 把管道中的数据写到fd
+    ssize_t writeFd(int fd, int *saveErrno);
+
+private:
+    // 期望的管道容量，实际容量以内核返回的为准
+    static const int kPipeSize = 256 * 1024;
+
+    int fds_[2];
+    size_t size_;
+    size_t capacity_;
+};
+} // namespace myMuduo
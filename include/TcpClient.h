@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CallBack.h"
+#include "InetAddress.h"
+#include "TcpConnection.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace myMuduo
+{
+class Connector;
+class EventLoop;
+
+/*
+    客户端：通过Connector在loop上非阻塞地连接serverAddr，连接成功后得到普通的TcpConnection，
+    和TcpServer的连接一样收发数据、使用同一个loop线程和对象池
+    同一时刻最多只有一个连接，enableRetry后连接断开会自动重连
+*/
+class TcpClient : noncopyable
+{
+public:
+    TcpClient(EventLoop *loop,
+              const InetAddress &serverAddr,
+              const std::string &name);
+    ~TcpClient();
+
+    // 以下三个函数可以在任意线程中调用
+    void connect();
+    // shutdown当前连接，不再重连
+    void disconnect();
+    // 停止正在进行的连接或重试
+    void stop();
+
+    // 当前的连接，没有连接时返回空指针，可以在任意线程中调用
+    TcpConnectionPtr connection() const;
+
+    EventLoop *getLoop() const { return loop_; }
+    const std::string &name() const { return name_; }
+
+    // 连接断开后自动重连（退避时间从头开始）
+    void enableRetry() { retry_ = true; }
+    bool retry() const { return retry_; }
+
+    // 回调在connect之前设置
+    void setConnectionCallBack(const ConnectionCallBack &cb)
+    {
+        mutableHandlers().connectionCallBack = cb;
+    }
+    void setMessageCallBack(const MessageCallBack &cb)
+    {
+        mutableHandlers().messageCallBack = cb;
+    }
+    void setWriteCompleteCallBack(const WriteCompleteCallBack &cb)
+    {
+        mutableHandlers().writeCompleteCallBack = cb;
+    }
+
+private:
+    // 在loop线程中调用
+    void newConnection(int sockfd);
+    void removeConnection(const TcpConnectionPtr &conn);
+    ConnectionHandlers &mutableHandlers();
+
+    EventLoop *loop_;
+    std::shared_ptr<Connector> connector_;
+    const std::string name_;
+    std::shared_ptr<ConnectionHandlers> handlers_;
+    std::atomic_bool retry_;
+    std::atomic_bool connect_;
+    uint64_t nextConnId_; // 只在loop线程中使用
+    mutable std::mutex mutex_;
+    TcpConnectionPtr connection_; // 由mutex_保护
+};
+} // namespace myMuduo
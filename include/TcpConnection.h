@@ -2,19 +2,29 @@
 
 #include "Buffer.h"
 #include "CallBack.h"
+#include "Channel.h"
 #include "InetAddress.h"
+#include "OutputQueue.h"
+#include "SharedBuffer.h"
+#include "Socket.h"
 #include "Timestamp.h"
 #include "noncopyable.h"
 
 #include <atomic>
+#include <initializer_list>
+#include <limits.h>
 #include <memory>
+#include <stdint.h>
 #include <string>
+#include <string_view>
+#include <vector>
+
+struct iovec;
 
 namespace myMuduo
 {
-class Channel;
 class EventLoop;
-class Socket;
+class SplicePipe;
 
 /*
     TcpServer通过Acceptor的listing监听新连接，通过accept函数拿到connfd
@@ -26,42 +36,111 @@ class TcpConnection : noncopyable,
 {
 public:
     TcpConnection(EventLoop *loop,
-                  const std::string &name,
+                  uint64_t id,
                   int sockfd,
-                  const InetAddress &localAddr,
                   const InetAddress &peerAddr);
     ~TcpConnection();
 
     EventLoop *getloop() const { return loop_; }
-    const std::string &name() const { return name_; }
-    const InetAddress &localAddress() const { return localAddr_; }
+    uint64_t id() const { return id_; }
+    // 连接名为回调表中的前缀加上#id，只在需要时（如打印日志）拼接
+    std::string name() const;
+    // 本端地址不保存在连接中，需要时通过getsockname获取
+    InetAddress localAddress() const;
     const InetAddress &peerAddress() const { return peerAddr_; }
     bool connected() const { return state_ == kConnected; }
 
-    // 发送数据
+    // 发送数据，非loop线程调用时会拷贝一份数据交给loop线程
     void send(const std::string &buf);
+    // 非loop线程调用时把数据移动到loop线程，不拷贝
+    void send(std::string &&buf);
+    void send(const void *data, size_t len);
+    // 发送buf中所有可读数据，调用后buf被清空（跨线程时直接交换内部存储）
+    void send(Buffer *buf);
+    // 发送共享的只读数据，跨线程时只增加引用计数
+    void send(const SharedBuffer &buf);
+    // 把多段数据（如header + body + trailer）作为一个整体发送，
+    // 不需要先拼接成一个临时string，loop线程中直接用一次writev写出
+    void sendv(std::initializer_list<std::string_view> pieces);
+    void sendv(std::vector<SharedBuffer> pieces);
+    // 用sendfile发送文件fd中[offset, offset + length)的内容，和其他send的数据按调用顺序发出，
+    // 全部发送完成后回调writeCompleteCallBack_。内部会dup一份fd，调用返回后即可关闭fd
+    void sendFile(int fd, off_t offset, size_t length);
 
     // 关闭服务器的连接
     void shutdown();
+    // 不等待发送队列中的数据发完，直接关闭连接
+    void forceClose();
+    // 关闭Nagle算法，小请求（比如流水线上的请求）立即发出
+    void setTcpNoDelay(bool on) { socket_.setTcpNoDelay(on); }
+
+    // 把本连接之后收到的数据通过splice直接转发给peer，数据不经过用户态缓冲区，
+    // 也不再回调messageCallBack_。peer必须属于同一个loop，peer发送不及时时暂停读取本连接。
+    // 本连接读到EOF时会在数据转发完后shutdown peer，本连接停止读取但继续发送peer转发来的数据，
+    // 本连接的写端也关闭后（peer读到EOF并转发完）才关闭连接。双向转发需要两边各调用一次
+    void startSplice(const TcpConnectionPtr &peer);
+
+    // 开始/停止读取socket上的数据，停止后对端发送过快时由TCP流控限制对端
+    void startRead();
+    void stopRead();
+    bool isReading() const { return reading_; }
+
+    // inputBuffer_中的数据达到highWaterMark时自动暂停读取，应用消费到lowWaterMark以下后恢复读取
+    // 每轮循环结束时检查一次是否可以恢复，highWaterMark为0表示不限制（默认）
+    void setInputWaterMark(size_t highWaterMark, size_t lowWaterMark);
+
+    // 长度大于等于threshold的数据使用MSG_ZEROCOPY发送，0表示关闭（默认）
+    // 零拷贝只对SharedBuffer和右值string生效，数据在内核发送完成前一直被持有
+    void setZeroCopyThreshold(size_t threshold);
+
+    // 打开auto cork后，loop线程中的send只追加到发送队列，
+    // 同一轮循环中的所有发送在循环结束时合并成一次writev
+    void setAutoCork(bool on);
+    // 显式批量发送时使用：打开TCP_CORK后内核攒满一个MSS才发包，关闭时发出剩余数据
+    void setTcpCork(bool on);
+
+    // 设置回调表，TcpServer让所有连接共享同一张表
+    void setHandlers(std::shared_ptr<const ConnectionHandlers> handlers)
+    {
+        handlers_ = std::move(handlers);
+    }
 
-    // 设置回调
+    // 单独设置本连接的回调，回调表被共享时先拷贝一份
     void setConnectionCallBack(const ConnectionCallBack &cb)
     {
-        connectionCallBack_ = cb;
+        mutableHandlers().connectionCallBack = cb;
     }
     void setMessageCallBack(const MessageCallBack &cb)
     {
-        messageCallBack_ = cb;
+        mutableHandlers().messageCallBack = cb;
     }
     void setWriteCompleteCallBack(const WriteCompleteCallBack &cb)
     {
-        writeCompleteCallBack_ = cb;
+        mutableHandlers().writeCompleteCallBack = cb;
     }
     void setHighWaterMarkCallBack(const HighWaterMarkCallBack &cb)
     {
-        highWaterMarkCallBack_ = cb;
+        mutableHandlers().highWaterMarkCallBack = cb;
+    }
+    void setHighWaterMarkCallBack(const HighWaterMarkCallBack &cb,
+                                  size_t highWaterMark)
+    {
+        ConnectionHandlers &handlers = mutableHandlers();
+        handlers.highWaterMarkCallBack = cb;
+        handlers.highWaterMark = highWaterMark;
+    }
+    // 发送队列超过高水位之后，又降到lowWaterMark及以下时回调，通知生产者恢复发送
+    void setLowWaterMarkCallBack(const LowWaterMarkCallBack &cb,
+                                 size_t lowWaterMark)
+    {
+        ConnectionHandlers &handlers = mutableHandlers();
+        handlers.lowWaterMarkCallBack = cb;
+        handlers.lowWaterMark = lowWaterMark;
+    }
+    void setCloseCallBack(const CloseCallBack &cb)
+    {
+        mutableHandlers().closeCallBack = cb;
     }
-    void setCloseCallBack(const CloseCallBack &cb) { closeCallBack_ = cb; }
 
     // 建立连接
     void connectEstablished();
@@ -75,8 +154,31 @@ private:
     void handleError();
 
     void sendInLoop(const void *data, size_t len);
+    void sendInLoop(const SharedBuffer &buf);
+    void sendvInLoop(const std::string_view *pieces, size_t count);
+    void sendvInLoop(const std::vector<SharedBuffer> &pieces);
+    bool writeDirectly(const struct iovec *vec,
+                       int iovcnt,
+                       size_t totalLen,
+                       size_t *nwrote);
+    void outputQueued(size_t oldlen);
+    void sendFileInLoop(int fd, off_t offset, size_t length);
+    void startSpliceInLoop(const TcpConnectionPtr &peer);
+    void handleSpliceRead(const TcpConnectionPtr &target);
+    void writeSpliced();
+    void flushOutput();
+    void queueOutput(size_t oldlen, bool idle);
+    void updateReading();
+    void outputDrained();
+    void startReadInLoop();
+    void stopReadInLoop();
+    void checkInputResume();
+    bool handleZeroCopyCompletions();
 
     void shutdownInLoop();
+    void forceCloseInLoop();
+
+    ConnectionHandlers &mutableHandlers();
 
     // 连接状态
     enum StateE
@@ -89,28 +191,44 @@ private:
 
     void setState(StateE state) { state_ = state; }
 
+    // 一次writev最多携带的数据段个数
+    static constexpr size_t kMaxIovecs = IOV_MAX;
+    // 超过OutputBudget时，发送队列至少这么大的连接才会被暂停读取
+    static constexpr size_t kMinBudgetPauseBytes = 64 * 1024;
+
     EventLoop *loop_; // subloop
-    const std::string name_;
+    const uint64_t id_;
     std::atomic<int> state_;
-    bool reading_;
+    bool reading_;     // 应用是否希望读取数据
+    bool inputPaused_; // 是否因为inputBuffer_达到高水位暂停了读取
+    bool outputPaused_; // 是否因为进程的发送内存超过OutputBudget暂停了读取
+    bool aboveHighWaterMark_; // 发送队列是否超过了高水位还没有降到低水位
+    bool autoCork_;     // 是否合并同一轮循环中的发送
+    bool flushPending_; // 是否已经注册了本轮循环结束时的flush
+    bool writeShutdown_; // 是否已经关闭了写端
+    bool peerClosed_;    // splice转发时对端已经关闭写端，等本端写端也关闭后再关闭连接
 
     // 这里和Acceptor类似       Acceptor=>mainLoop        TcpConnection=>subLoop
-    std::unique_ptr<Socket> socket_;
-    std::unique_ptr<Channel> channel_;
+    // 直接作为成员，和TcpConnection在同一块内存中，不需要单独分配
+    Socket socket_;
+    Channel channel_;
 
-    const InetAddress localAddr_;
     const InetAddress peerAddr_;
 
-    ConnectionCallBack connectionCallBack_;       // 有新连接的回调
-    MessageCallBack messageCallBack_;             // 有可读写消息的回调
-    WriteCompleteCallBack writeCompleteCallBack_; // 消息发送完成后的回调
-    HighWaterMarkCallBack highWaterMarkCallBack_; // 高水位回调
-    CloseCallBack closeCallBack_;
+    // 回调和发送队列的高低水位，和同一个TcpServer的其他连接共享
+    std::shared_ptr<const ConnectionHandlers> handlers_;
+
+    size_t inputHighWaterMark_; // 避免对端发送的太快而应用处理太慢，inputBuffer_无限增长
+    size_t inputLowWaterMark_;
 
-    size_t highWaterMark_; // 避免发送的太快，而接收太慢造成队头阻塞
+    // splice转发：本连接读到的数据转发给spliceTarget_，
+    // spliceSource_读到的数据经过splicePipe_写到本连接
+    std::weak_ptr<TcpConnection> spliceTarget_;
+    std::weak_ptr<TcpConnection> spliceSource_;
+    std::unique_ptr<SplicePipe> splicePipe_;
 
     Buffer inputBuffer_;  // 接收数据的缓冲区
-    Buffer outputBuffer_; // 发送数据的缓冲区
+    OutputQueue outputQueue_; // 发送队列，可以引用SharedBuffer而不拷贝
 };
 
 } // namespace myMuduo
\ No newline at end of file
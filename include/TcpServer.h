@@ -6,14 +6,19 @@
 #include "EventLoop.h"
 #include "EventLoopThreadPool.h"
 #include "InetAddress.h"
+#include "ListenSocketHandoff.h"
+#include "OutputBudget.h"
 #include "TcpConnection.h"
+#include "Timestamp.h"
 #include "noncopyable.h"
 
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace myMuduo
 {
@@ -26,6 +31,7 @@ class TcpServer : noncopyable
 {
 public:
     using ThreadInitCallBack = std::function<void(EventLoop *)>;
+    using DrainCallBack = std::function<void(size_t remaining)>;
 
     enum Option
     {
@@ -37,24 +43,46 @@ public:
               const InetAddress &listenAddr,
               const std::string &name,
               Option option = kNoReusePort);
+    // 接管一个已经处于监听状态的fd，用于热升级时从旧进程继承监听socket
+    TcpServer(EventLoop *loop, int listenFd, const std::string &name);
     ~TcpServer();
 
     void setThreadInitCallBack(const ThreadInitCallBack &cb)
     {
         threadInitCallBack_ = cb;
     }
+    // 回调保存在handlers_中，所有连接共享同一份，需要在start之前设置
     void setConnectionCallBack(const ConnectionCallBack &cb)
     {
-        connectionCallBack_ = cb;
+        mutableHandlers().connectionCallBack = cb;
     }
     void setMessageCallBack(const MessageCallBack &cb)
     {
-        messageCallBack_ = cb;
+        mutableHandlers().messageCallBack = cb;
     }
     void setWriteCompleteCallBack(const WriteCompleteCallBack &cb)
     {
-        writeCompleteCallBack_ = cb;
+        mutableHandlers().writeCompleteCallBack = cb;
     }
+    // 每个连接发送队列的高低水位，新连接建立时设置
+    void setHighWaterMarkCallBack(const HighWaterMarkCallBack &cb,
+                                  size_t highWaterMark)
+    {
+        ConnectionHandlers &handlers = mutableHandlers();
+        handlers.highWaterMarkCallBack = cb;
+        handlers.highWaterMark = highWaterMark;
+    }
+    void setLowWaterMarkCallBack(const LowWaterMarkCallBack &cb,
+                                 size_t lowWaterMark)
+    {
+        ConnectionHandlers &handlers = mutableHandlers();
+        handlers.lowWaterMarkCallBack = cb;
+        handlers.lowWaterMark = lowWaterMark;
+    }
+
+    // 进程内所有连接发送队列占用内存的上限，所有TcpServer共享，0表示不限制（默认）
+    // 超过上限后拒绝新连接，并暂停读取发送队列较大的连接，直到它们的数据发送到低水位
+    void setOutputMemoryBudget(size_t bytes) { OutputBudget::setLimit(bytes); }
 
     // 设置subloop个数
     void setThreadNum(int numThreads);
@@ -62,29 +90,88 @@ public:
     // 开启服务器监听
     void start();
 
+    // 优雅退出：停止接受新连接，每个连接在发送队列发完后shutdown，
+    // drainTimeout秒后还没有关闭的连接被强制关闭。等待期间定期用剩余的连接数回调cb，
+    // 所有连接都关闭后最后回调一次cb(0)，在此之前TcpServer不能析构。可以在任意线程中调用
+    void stop(double drainTimeout, DrainCallBack cb = DrainCallBack());
+
+    // 热升级：在Unix域socket path上等待新进程，新进程用ListenSocketHandoff::receive
+    // 取得监听fd后回调cb，一般在cb中调用stop排空已有连接。需要在start之后调用
+    void enableHandoff(const std::string &path,
+                       const ListenSocketHandoff::HandoffCallBack &cb);
+
+    // 根据连接id查找连接，可以在任意线程中调用，连接已经关闭时返回空指针
+    // 只锁住该连接所属subloop的分片，不同subloop的连接互不影响
+    TcpConnectionPtr getConnection(uint64_t id) const;
+    // 当前的连接个数
+    size_t connectionCount() const;
+
+    // 把同一份数据发送给conns中的所有连接，数据只被引用不拷贝
+    // 连接按所属的subloop分组，每个subloop只投递一次任务
+    static void broadcast(const std::vector<TcpConnectionPtr> &conns,
+                          const SharedBuffer &buf);
+
 private:
+    TcpServer(EventLoop *loop,
+              Acceptor *acceptor,
+              const std::string &ipPort,
+              const std::string &name);
+
     void newConnection(int sockfd, const InetAddress &peerAddr);
     void removeConnection(const TcpConnectionPtr &conn);
-    void removeConnectionInLoop(const TcpConnectionPtr &conn);
+    void stopInLoop(double drainTimeout, const DrainCallBack &cb);
+    void checkDrain(Timestamp deadline,
+                    const DrainCallBack &cb,
+                    bool forced);
+    std::vector<TcpConnectionPtr> allConnections() const;
+    ConnectionHandlers &mutableHandlers();
+
+    using ConnectionMap = std::unordered_map<uint64_t, TcpConnectionPtr>;
+
+    // 一个subloop上的所有连接，id % loops_.size()相同的连接属于同一个subloop
+    // 连接在subloop中关闭时直接从分片中删除，不需要再切换到baseloop
+    // 连接在subloop中构造后才登记，构造任务持有分片的引用，TcpServer析构后分片被标记为closed
+    struct ConnectionShard
+    {
+        mutable std::mutex mutex;
+        ConnectionMap connections;
+        bool closed = false;
+    };
+
+    // 优雅退出时检查剩余连接数的间隔
+    static constexpr double kDrainCheckInterval = 0.1;
+
+    ConnectionShard &shardOf(uint64_t id) const
+    {
+        return *shards_[id % shards_.size()];
+    }
 
-    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+    // 在ioLoop中构造连接并登记到分片，连接从ioLoop的对象池分配，分配和释放都在ioLoop线程中
+    // 不访问TcpServer，构造任务执行前TcpServer已经析构时直接关闭sockfd
+    static void newConnectionInLoop(EventLoop *ioLoop,
+                                    const std::shared_ptr<ConnectionShard> &shard,
+                                    const std::shared_ptr<ConnectionHandlers> &handlers,
+                                    uint64_t id,
+                                    int sockfd,
+                                    const InetAddress &peerAddr);
 
     EventLoop *loop_;                    // 用户定义的loop，baseloop
     const std::string ipPort_;           // 服务器地址
     const std::string name_;             // 服务器名
     std::unique_ptr<Acceptor> acceptor_; // 运行在mainloop,监听新连接事件
+    std::unique_ptr<ListenSocketHandoff> handoff_; // 热升级时交出监听fd
     std::shared_ptr<EventLoopThreadPool> threadPool_; // one loop per thread
 
-    ConnectionCallBack connectionCallBack_;       // 有新连接的回调
-    MessageCallBack messageCallBack_;             // 有可读写消息的回调
-    WriteCompleteCallBack writeCompleteCallBack_; // 消息发送完成后的回调
+    // 所有连接共享的回调表，修改时如果已经有连接在用，先拷贝一份新的
+    std::shared_ptr<ConnectionHandlers> handlers_;
 
     ThreadInitCallBack threadInitCallBack_; // 线程初始化时的回调
 
     std::atomic_int started_;
 
-    int nextConnId_;
+    uint64_t nextConnId_;
 
-    ConnectionMap connections_; // 保存所有的连接
+    std::vector<EventLoop *> loops_; // start之后所有的subloop，没有subloop时为baseloop
+    std::vector<std::shared_ptr<ConnectionShard>> shards_; // 和loops_一一对应
 };
 } // namespace myMuduo
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Channel.h"
+#include "noncopyable.h"
+
+#include <chrono>
+#include <functional>
+#include <map>
+
+namespace myMuduo
+{
+class EventLoop;
+
+/*
+    定时器队列，所有定时器共用一个timerfd，注册到所属的EventLoop上
+    timerfd总是设置为最早到期的定时器的时间，到期后执行所有已经到期的回调
+    只能在所属loop的线程中使用，其他线程通过EventLoop::runAfter投递
+*/
+class TimerQueue : noncopyable
+{
+public:
+    using Functor = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    explicit TimerQueue(EventLoop *loop);
+    ~TimerQueue();
+
+    // 在when时刻执行cb
+    void addTimer(Clock::time_point when, Functor cb);
+
+private:
+    // timerfd可读，说明有定时器到期
+    void handleRead();
+    // 把timerfd设置为最早到期的定时器的时间
+    void resetTimerfd();
+
+    EventLoop *loop_;
+    const int timerfd_;
+    Channel timerChannel_;
+    std::multimap<Clock::time_point, Functor> timers_; // 按到期时间排序
+};
+} // namespace myMuduo
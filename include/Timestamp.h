@@ -1,21 +1,61 @@
 #pragma once
 
-#include <iostream>
+#include <compare>
+#include <stdint.h>
+#include <stddef.h>
 #include <string>
+#include <time.h>
 
 namespace myMuduo
 {
+// 微秒精度的时间点，值类型，可以直接按值传递
 class Timestamp
 {
 public:
     Timestamp();
     explicit Timestamp(int64_t microSecondsSinceEpoch);
-    // 获取当前时间
+    // 获取当前时间（CLOCK_REALTIME）
     static Timestamp now();
-    // 时间转为string
+    // CLOCK_MONOTONIC，不受系统时间调整影响，只用来计算间隔和deadline，不能转为日期
+    static Timestamp monotonicNow();
+    static Timestamp invalid() { return Timestamp(); }
+
+    bool valid() const { return microSecondsSinceEpoch_ > 0; }
+    int64_t microSecondsSinceEpoch() const { return microSecondsSinceEpoch_; }
+    time_t secondsSinceEpoch() const
+    {
+        return static_cast<time_t>(microSecondsSinceEpoch_ /
+                                   kMicroSecondsPerSecond);
+    }
+
+    // 时间转为string  格式: 年/月/日 时:分:秒
     std::string toString() const;
+    // 格式: 年/月/日 时:分:秒[.微秒]
+    std::string toFormattedString(bool showMicroseconds = true) const;
+    // 同toFormattedString，写入buf（以'\0'结尾），返回写入的长度，不分配内存
+    // 同一线程同一秒内只在第一次调用localtime_r，之后只做整数运算
+    size_t formatTo(char *buf, size_t size, bool showMicroseconds = true) const;
+
+    auto operator<=>(const Timestamp &) const = default;
+
+    static constexpr int64_t kMicroSecondsPerSecond = 1000 * 1000;
 
 private:
     int64_t microSecondsSinceEpoch_;
 };
-} // namespace myMuduo
\ No newline at end of file
+
+// high - low，单位秒
+inline double timeDifference(Timestamp high, Timestamp low)
+{
+    int64_t diff = high.microSecondsSinceEpoch() - low.microSecondsSinceEpoch();
+    return static_cast<double>(diff) / Timestamp::kMicroSecondsPerSecond;
+}
+
+// timestamp之后seconds秒的时间点，用来计算deadline
+inline Timestamp addTime(Timestamp timestamp, double seconds)
+{
+    int64_t delta =
+        static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+    return Timestamp(timestamp.microSecondsSinceEpoch() + delta);
+}
+} // namespace myMuduo
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "EventLoop.h"
+#include "EventLoopThreadPool.h"
+#include "InetAddress.h"
+#include "UdpSocket.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace myMuduo
+{
+/*
+    UDP服务器：每个subloop各自bind一个设置了SO_REUSEPORT的UdpSocket到同一个地址，
+    内核按四元组的哈希把数据报分给不同的socket，同一个对端的数据报总在同一个subloop中处理，
+    subloop之间不共享任何状态。没有subloop时只在baseloop上创建一个socket
+*/
+class UdpServer : noncopyable
+{
+public:
+    using ThreadInitCallBack = std::function<void(EventLoop *)>;
+
+    UdpServer(EventLoop *loop,
+              const InetAddress &listenAddr,
+              const std::string &name);
+    // 每个socket在自己的loop线程中析构，可以在baseloop线程中调用
+    ~UdpServer();
+
+    // 以下设置需要在start之前调用
+    void setThreadInitCallBack(const ThreadInitCallBack &cb)
+    {
+        threadInitCallBack_ = cb;
+    }
+    void setThreadNum(int numThreads);
+    void setMessageCallBack(const UdpSocket::DatagramCallBack &cb)
+    {
+        messageCallBack_ = cb;
+    }
+    // 每个socket一次recvmmsg/sendmmsg处理的数据报个数
+    void setBatchSize(int batchSize) { batchSize_ = batchSize; }
+    void setDatagramSize(size_t datagramSize) { datagramSize_ = datagramSize; }
+    // 内核不支持时忽略
+    void enableGro(bool on) { gro_ = on; }
+    void enableGso(bool on) { gso_ = on; }
+
+    void start();
+
+    // 所有socket的统计值之和，可以在任意线程中调用
+    uint64_t receivedDatagrams() const;
+    uint64_t sentDatagrams() const;
+    uint64_t droppedDatagrams() const;
+
+    const std::string &name() const { return name_; }
+
+private:
+    EventLoop *loop_; // baseloop
+    const InetAddress listenAddr_;
+    const std::string name_;
+    std::shared_ptr<EventLoopThreadPool> threadPool_;
+    ThreadInitCallBack threadInitCallBack_;
+    UdpSocket::DatagramCallBack messageCallBack_;
+    int batchSize_;
+    size_t datagramSize_;
+    bool gro_;
+    bool gso_;
+    std::atomic_int started_;
+
+    std::vector<std::shared_ptr<UdpSocket>> sockets_; // 每个loop一个
+};
+} // namespace myMuduo
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Channel.h"
+#include "InetAddress.h"
+#include "Socket.h"
+#include "Timestamp.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+namespace myMuduo
+{
+class EventLoop;
+
+/*
+    注册在一个loop上的UDP socket，可以作为服务器（bind到固定端口）或客户端（bind到端口0）
+        接收：可读时用recvmmsg一次读取一批数据报，接收缓冲区在构造时一次分配好，逐个回调
+        发送：sendTo先把数据报追加到发送批次中，本轮事件处理完（或者批次满）时用sendmmsg一起发出
+        GSO/GRO：内核支持时，sendSegments把同一个目的地址的多个等长数据报交给内核分段，
+                 enableGro后内核合并的数据报在回调前按分段大小拆开
+    除构造外的操作都要在loop线程中进行。在回调之外sendTo时要延迟到本轮事件之后发送，
+    需要用std::shared_ptr管理UdpSocket，否则数据报立即发出
+*/
+class UdpSocket : noncopyable, public std::enable_shared_from_this<UdpSocket>
+{
+public:
+    // data只在回调期间有效，回调中可以调用socket->sendTo回复
+    using DatagramCallBack =
+        std::function<void(UdpSocket *socket,
+                           const char *data,
+                           size_t len,
+                           const InetAddress &peer,
+                           Timestamp receiveTime)>;
+
+    // 一次recvmmsg/sendmmsg最多处理的数据报个数
+    static constexpr int kDefaultBatchSize = 64;
+    // 不开GRO时每个数据报的接收缓冲区大小，更长的数据报被截断并丢弃
+    static constexpr size_t kDefaultDatagramSize = 2048;
+
+    UdpSocket(EventLoop *loop,
+              const InetAddress &bindAddr,
+              bool reuseport = false,
+              int batchSize = kDefaultBatchSize,
+              size_t datagramSize = kDefaultDatagramSize);
+    // 在loop线程中析构，还没有发出的数据报会先发送
+    ~UdpSocket();
+
+    void setMessageCallBack(DatagramCallBack cb) { messageCallBack_ = std::move(cb); }
+
+    // 内核不支持时返回false。开启GRO后每个接收缓冲区扩大到64KB
+    bool enableGro();
+    // 探测内核是否支持UDP_SEGMENT，不支持时sendSegments退化为逐个sendTo
+    bool enableGso();
+
+    // 开始接收数据报
+    void start();
+    void stop();
+
+    void sendTo(const char *data, size_t len, const InetAddress &peer);
+    void sendTo(const std::string &data, const InetAddress &peer)
+    {
+        sendTo(data.data(), data.size(), peer);
+    }
+    // data由若干个segmentSize大小的数据报依次拼接而成（最后一个可以更短）
+    void sendSegments(const char *data,
+                      size_t len,
+                      size_t segmentSize,
+                      const InetAddress &peer);
+    // 立即发出发送批次中的数据报
+    void flush();
+
+    int fd() const { return socket_.fd(); }
+    EventLoop *getLoop() const { return loop_; }
+    // 实际bind的地址，bind到端口0时可以用来取得内核分配的端口
+    InetAddress localAddress() const;
+
+    // 统计值可以在任意线程中读取
+    uint64_t receivedDatagrams() const { return received_.load(std::memory_order_relaxed); }
+    uint64_t sentDatagrams() const { return sent_.load(std::memory_order_relaxed); }
+    // 被截断的接收数据报和发送失败的数据报个数
+    uint64_t droppedDatagrams() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    // 发送批次中的一个数据报，data保存在sendBuf_[offset, offset + len)中
+    struct PendingDatagram
+    {
+        size_t offset;
+        size_t len;
+        InetAddress peer;
+        uint16_t segmentSize; // 不为0时由内核按这个大小分段
+    };
+
+    void handleRead(Timestamp receiveTime);
+    void setupRecvBuffers();
+    void append(const char *data,
+                size_t len,
+                const InetAddress &peer,
+                uint16_t segmentSize);
+
+    EventLoop *loop_;
+    Socket socket_;
+    Channel channel_;
+    DatagramCallBack messageCallBack_;
+    const int batchSize_;
+    size_t datagramSize_;
+    bool gro_;
+    bool gso_;
+    bool handlingRead_; // 正在回调时sendTo攒到handleRead结束时一起发送
+    bool flushQueued_;
+
+    // 接收批次，构造（或开启GRO）时一次分配好
+    std::vector<char> recvBuf_;
+    std::vector<mmsghdr> recvMsgs_;
+    std::vector<iovec> recvIovecs_;
+    std::vector<sockaddr_storage> recvAddrs_;
+    std::vector<char> recvControl_;
+
+    std::vector<char> sendBuf_;
+    std::vector<PendingDatagram> pending_;
+    std::vector<mmsghdr> sendMsgs_;
+    std::vector<iovec> sendIovecs_;
+    std::vector<char> sendControl_;
+
+    std::atomic<uint64_t> received_;
+    std::atomic<uint64_t> sent_;
+    std::atomic<uint64_t> dropped_;
+};
+} // namespace myMuduo
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CallBack.h"
+#include "InetAddress.h"
+#include "Timestamp.h"
+#include "noncopyable.h"
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+namespace myMuduo
+{
+class Buffer;
+class EventLoop;
+class TcpClient;
+
+/*
+    单个loop内的后端连接池：对每个后端（endpoint）保持若干条长连接，
+    请求在同一条连接上流水线发送（不等上一个响应），响应按发送顺序依次交给对应的回调
+    所有操作都在所属loop的线程中进行，不加锁、不跨线程；每个IO线程各建一个连接池
+    （比如在TcpServer::setThreadInitCallBack中创建），后端请求只走本线程的连接
+        选择：在可用的连接中选未完成请求最少的一条
+        健康检查：连接带着未完成的请求断开、或者响应无法解析算一次失败，
+                  连续失败maxFailures次的后端被摘除ejectionTime秒，期间不再分配请求，
+                  收到正常响应后失败计数清零
+        预热：start时就建立所有连接，断开后由TcpClient按退避时间重连
+*/
+class UpstreamPool : noncopyable
+{
+public:
+    // 从buf开头解析一个完整的响应，返回它的长度，数据不够返回0，格式错误返回-1
+    using ResponseParser = std::function<ssize_t(const Buffer *buf)>;
+    // 收到响应时ok为true，response只在回调期间有效
+    // 连接断开、响应无法解析时ok为false，response为空
+    using ResponseCallBack =
+        std::function<void(bool ok, std::string_view response)>;
+
+    struct EndpointStatus
+    {
+        InetAddress addr;
+        int connected;      // 已经建立的连接数
+        size_t outstanding; // 已发送、还没有收到响应的请求数
+        uint64_t responses;
+        uint64_t failures;
+        bool ejected;
+    };
+
+    UpstreamPool(EventLoop *loop,
+                 const std::string &name,
+                 ResponseParser parser);
+    // 必须在loop线程中析构，未完成的请求以ok = false回调
+    ~UpstreamPool();
+
+    // 以下设置在start之前调用
+    void addEndpoint(const InetAddress &addr);
+    void setConnectionsPerEndpoint(int n) { connectionsPerEndpoint_ = n; }
+    void setMaxFailures(int n) { maxFailures_ = n; }
+    void setEjectionTime(double seconds) { ejectionTime_ = seconds; }
+
+    // 在loop线程中调用，建立到所有后端的连接
+    void start();
+
+    // 在loop线程中调用，没有可用的连接时返回false，不会回调cb
+    bool send(std::string_view request, ResponseCallBack cb);
+
+    // 已经建立的连接数
+    int connectedCount() const;
+    std::vector<EndpointStatus> status() const;
+
+private:
+    struct Endpoint;
+
+    // 一条到后端的长连接
+    struct Upstream
+    {
+        Endpoint *endpoint;
+        std::unique_ptr<TcpClient> client;
+        TcpConnectionPtr conn; // 连接建立之后才有
+        std::deque<ResponseCallBack> pending; // 等待响应的请求，按发送顺序排列
+    };
+
+    struct Endpoint
+    {
+        InetAddress addr;
+        int failures = 0;      // 连续失败的次数
+        Timestamp ejectedUntil; // 在此之前不分配请求
+        uint64_t responses = 0;
+        uint64_t totalFailures = 0;
+    };
+
+    void onConnection(Upstream *upstream, const TcpConnectionPtr &conn);
+    void onMessage(Upstream *upstream, const TcpConnectionPtr &conn, Buffer *buf);
+    // 以失败回调upstream上所有未完成的请求
+    void failPending(Upstream *upstream);
+    void recordFailure(Endpoint *endpoint);
+    bool available(const Upstream *upstream, Timestamp now) const;
+
+    EventLoop *loop_;
+    const std::string name_;
+    ResponseParser parser_;
+    int connectionsPerEndpoint_;
+    int maxFailures_;
+    double ejectionTime_;
+    bool started_;
+
+    std::vector<std::unique_ptr<Endpoint>> endpoints_;
+    std::vector<std::unique_ptr<Upstream>> upstreams_;
+    size_t next_; // 轮询起点，未完成请求数相同的连接轮流使用
+};
+} // namespace myMuduo
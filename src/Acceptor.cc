@@ -3,17 +3,20 @@
 #include "Logger.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 namespace myMuduo
 {
-static int createNonblocking()
+static int createNonblocking(sa_family_t family)
 {
-    int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
-                          IPPROTO_TCP);
+    // Unix域socket没有IPPROTO_TCP，由内核按地址族选择协议
+    int sockfd =
+        ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (sockfd < 0)
     {
         LOG_FATAL("%s:%s:%d listen socket create err:%d \n", __FILE__, __func__,
@@ -22,14 +25,55 @@ static int createNonblocking()
     return sockfd;
 }
 
+// 上次运行留下的socket文件会让bind失败，只删除确实没有进程在监听的socket文件
+static void removeStaleUnixSocket(const InetAddress &listenAddr)
+{
+    const sockaddr_un *addr =
+        reinterpret_cast<const sockaddr_un *>(listenAddr.getSockAddr());
+    // 抽象命名空间的地址没有文件
+    struct stat st;
+    if (addr->sun_path[0] == '\0' || ::stat(addr->sun_path, &st) < 0)
+    {
+        return;
+    }
+    if (!S_ISSOCK(st.st_mode))
+    {
+        LOG_FATAL("Acceptor - %s exists and is not a socket \n", addr->sun_path);
+    }
+
+    // 能连上（或者监听队列已满返回EAGAIN）说明另一个进程正在使用这个地址
+    int sockfd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int ret = ::connect(sockfd, listenAddr.getSockAddr(), listenAddr.getSockLen());
+    int err = errno;
+    ::close(sockfd);
+    if (ret == 0 || err == EAGAIN)
+    {
+        LOG_FATAL("Acceptor - %s is in use by a running server \n",
+                  addr->sun_path);
+    }
+    // 只有ECONNREFUSED能确定是残留的文件，其他错误留给bind报告
+    if (err == ECONNREFUSED)
+    {
+        ::unlink(addr->sun_path);
+    }
+}
+
 Acceptor::Acceptor(EventLoop *loop,
                    const InetAddress &listenAddr,
                    bool reuseport)
-    : loop_(loop), acceptSocket_(createNonblocking()),
-      acceptChannel_(loop, acceptSocket_.fd()), listening_(false)
+    : loop_(loop), acceptSocket_(createNonblocking(listenAddr.family())),
+      acceptChannel_(loop, acceptSocket_.fd()), listening_(false),
+      shared_(false)
 {
-    acceptSocket_.setReuseAddr(true);
-    acceptSocket_.setReusePort(reuseport);
+    if (listenAddr.isUnix())
+    {
+        removeStaleUnixSocket(listenAddr);
+    }
+    else
+    {
+        acceptSocket_.setReuseAddr(true);
+        acceptSocket_.setReusePort(reuseport);
+    }
     acceptSocket_.bindAddress(listenAddr);
 
     // 如果有新用户的连接，要执行一个回调，该回调将connfd => channel => subloop
@@ -37,6 +81,17 @@ Acceptor::Acceptor(EventLoop *loop,
     acceptChannel_.setReadCallBack(std::bind(&Acceptor::handleRead, this));
 }
 
+Acceptor::Acceptor(EventLoop *loop, int listenFd)
+    : loop_(loop), acceptSocket_(listenFd), acceptChannel_(loop, listenFd),
+      listening_(false), shared_(false)
+{
+    // 继承来的fd和旧进程共享同一个打开的文件，标志位一般已经设置好，这里再确认一次
+    int flags = ::fcntl(listenFd, F_GETFL, 0);
+    ::fcntl(listenFd, F_SETFL, flags | O_NONBLOCK);
+    ::fcntl(listenFd, F_SETFD, FD_CLOEXEC);
+    acceptChannel_.setReadCallBack(std::bind(&Acceptor::handleRead, this));
+}
+
 Acceptor::~Acceptor()
 {
     acceptChannel_.disableAll();
@@ -50,6 +105,22 @@ void Acceptor::listen()
     acceptChannel_.enableReading();
 }
 
+void Acceptor::stop()
+{
+    if (!listening_)
+    {
+        return;
+    }
+    listening_ = false;
+    acceptChannel_.disableAll();
+    // 对监听socket调用shutdown会让它退出LISTEN状态，端口可以被新进程接管，fd在析构时关闭
+    // 和其他进程共享的监听socket不能shutdown，否则对方也无法accept
+    if (!shared_)
+    {
+        ::shutdown(acceptSocket_.fd(), SHUT_RDWR);
+    }
+}
+
 // listenfd有事件发生了，就是有用户连接了
 void Acceptor::handleRead()
 {
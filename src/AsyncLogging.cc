@@ -0,0 +1,155 @@
+#include "AsyncLogging.h"
+#include "LogFile.h"
+
+#include <chrono>
+#include <stdio.h>
+
+namespace myMuduo
+{
+AsyncLogging::AsyncLogging(const std::string &basename,
+                           off_t rollSize,
+                           int flushInterval,
+                           size_t maxBufferedBytes)
+    : basename_(basename), rollSize_(rollSize), flushInterval_(flushInterval),
+      maxBuffers_(std::max<size_t>(maxBufferedBytes / kBufferSize, 2)),
+      running_(false), thread_(std::bind(&AsyncLogging::threadFunc, this),
+                               "AsyncLogging"),
+      currentBuffer_(new LogBuffer), nextBuffer_(new LogBuffer), dropped_(0),
+      totalDropped_(0)
+{
+    buffers_.reserve(16);
+}
+
+AsyncLogging::~AsyncLogging()
+{
+    if (running_)
+    {
+        stop();
+    }
+}
+
+void AsyncLogging::append(const char *logline, size_t len)
+{
+    // 一条日志放不进一个空缓冲区，丢弃并计数，否则换上新缓冲区后会越界
+    if (len >= kBufferSize)
+    {
+        ++dropped_;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (currentBuffer_->avail() > len)
+    {
+        currentBuffer_->append(logline, len);
+        return;
+    }
+
+    // 后台线程跟不上，丢掉这条日志，不让前端等待也不继续占用内存
+    if (buffers_.size() >= maxBuffers_)
+    {
+        ++dropped_;
+        return;
+    }
+
+    buffers_.push_back(std::move(currentBuffer_));
+    if (nextBuffer_)
+    {
+        currentBuffer_ = std::move(nextBuffer_);
+    }
+    else
+    {
+        currentBuffer_.reset(new LogBuffer); // 很少发生
+    }
+    currentBuffer_->append(logline, len);
+    cond_.notify_one();
+}
+
+void AsyncLogging::start()
+{
+    running_ = true;
+    thread_.start(); // 返回时后台线程已经在运行
+}
+
+void AsyncLogging::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+void AsyncLogging::threadFunc()
+{
+    LogFile output(basename_, rollSize_, flushInterval_);
+    // 后台线程预留两个空缓冲区，和前端交换时不需要分配内存
+    BufferPtr newBuffer1(new LogBuffer);
+    BufferPtr newBuffer2(new LogBuffer);
+    BufferVector buffersToWrite;
+    buffersToWrite.reserve(16);
+
+    while (true)
+    {
+        uint64_t dropped = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (buffers_.empty() && running_)
+            {
+                cond_.wait_for(lock, std::chrono::seconds(flushInterval_));
+            }
+            // 当前缓冲区不管有没有写满都一起取走
+            buffers_.push_back(std::move(currentBuffer_));
+            currentBuffer_ = std::move(newBuffer1);
+            buffersToWrite.swap(buffers_);
+            if (!nextBuffer_)
+            {
+                nextBuffer_ = std::move(newBuffer2);
+            }
+            dropped = dropped_.exchange(0);
+        }
+
+        if (dropped > 0)
+        {
+            char buf[128];
+            int n = snprintf(buf, sizeof buf,
+                             "AsyncLogging dropped %lu log messages\n", dropped);
+            output.append(buf, n);
+            totalDropped_ += dropped;
+        }
+        for (const BufferPtr &buffer : buffersToWrite)
+        {
+            output.append(buffer->data(), buffer->length());
+        }
+
+        // 留下两个缓冲区给下一轮使用，其余的释放
+        if (buffersToWrite.size() > 2)
+        {
+            buffersToWrite.resize(2);
+        }
+        if (!newBuffer1)
+        {
+            newBuffer1 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer1->reset();
+        }
+        if (!newBuffer2 && !buffersToWrite.empty())
+        {
+            newBuffer2 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer2->reset();
+        }
+        buffersToWrite.clear();
+        output.flush();
+
+        if (!running_)
+        {
+            // stop之后可能还有最后一批日志，再确认一次
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (buffers_.empty() && currentBuffer_->length() == 0)
+            {
+                break;
+            }
+        }
+    }
+}
+} // namespace myMuduo
@@ -0,0 +1,503 @@
+#include "BinaryLogging.h"
+#include "Timestamp.h"
+
+#include <deque>
+#include <stdio.h>
+#include <unistd.h>
+
+namespace myMuduo
+{
+thread_local BinaryLog::ThreadRing *BinaryLog::t_ring = nullptr;
+std::atomic_bool BinaryLog::running_(false);
+
+namespace
+{
+// 线程退出时把自己的环形缓冲区标记为retired，由后台线程取完后释放
+struct RingRetirer
+{
+    std::atomic_bool *retired = nullptr;
+    ~RingRetirer()
+    {
+        if (retired)
+        {
+            retired->store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local RingRetirer t_retirer;
+
+const char *levelName(LogLevel level)
+{
+    switch (level)
+    {
+        case DEBUG:
+            return "[DEBUG]";
+        case INFO:
+            return "[INFO]";
+        case ERROR:
+            return "[ERROR]";
+        case FATAL:
+            return "[FATAL]";
+        default:
+            return "";
+    }
+}
+} // namespace
+
+BinaryLog &BinaryLog::instance()
+{
+    static BinaryLog log;
+    return log;
+}
+
+BinaryLog::BinaryLog()
+    : file_(nullptr), retiredDropped_(0), stopping_(false)
+{
+}
+
+BinaryLog::~BinaryLog()
+{
+    if (thread_)
+    {
+        stop();
+    }
+}
+
+void BinaryLog::startText(OutputFunc output)
+{
+    if (thread_)
+    {
+        return;
+    }
+    output_ = std::move(output);
+    stopping_ = false;
+    thread_.reset(
+        new Thread(std::bind(&BinaryLog::threadFunc, this), "BinaryLog"));
+    thread_->start();
+    running_ = true;
+}
+
+bool BinaryLog::startFile(const std::string &path)
+{
+    if (thread_)
+    {
+        return false;
+    }
+    file_ = ::fopen(path.c_str(), "we");
+    if (!file_)
+    {
+        LOG_ERROR("BinaryLog: open %s failed, errno %d", path.c_str(), errno);
+        return false;
+    }
+    written_.clear();
+    stopping_ = false;
+    thread_.reset(
+        new Thread(std::bind(&BinaryLog::threadFunc, this), "BinaryLog"));
+    thread_->start();
+    running_ = true;
+    return true;
+}
+
+void BinaryLog::stop()
+{
+    if (!thread_)
+    {
+        return;
+    }
+    running_ = false;
+    stopping_ = true;
+    thread_->join();
+    thread_.reset();
+    if (file_)
+    {
+        ::fclose(file_);
+        file_ = nullptr;
+    }
+    output_ = nullptr;
+}
+
+uint64_t BinaryLog::droppedRecords() const
+{
+    uint64_t dropped = retiredDropped_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (ThreadRing *ring : rings_)
+    {
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+uint32_t BinaryLog::registerFormat(LogLevel level, const char *fmt,
+                                   const char *file, int line)
+{
+    BinaryLog &log = instance();
+    std::lock_guard<std::mutex> lock(log.mutex_);
+    log.formats_.push_back(FormatInfo{level, line, fmt, file});
+    return static_cast<uint32_t>(log.formats_.size() - 1);
+}
+
+void BinaryLog::createThreadRing()
+{
+    ThreadRing *ring = new ThreadRing;
+    {
+        BinaryLog &log = instance();
+        std::lock_guard<std::mutex> lock(log.mutex_);
+        log.rings_.push_back(ring);
+    }
+    t_ring = ring;
+    t_retirer.retired = &ring->retired;
+}
+
+char *BinaryLog::ThreadRing::beginWrite(size_t n)
+{
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    size_t offset = pos & (kSize - 1);
+    size_t contiguous = kSize - offset;
+    // 末尾放不下时跳过剩余部分，记录总是连续的
+    size_t need = contiguous < n ? contiguous + n : n;
+    if (pos + need - cachedTail > kSize)
+    {
+        cachedTail = tail.load(std::memory_order_acquire);
+        if (pos + need - cachedTail > kSize)
+        {
+            return nullptr;
+        }
+    }
+    if (contiguous < n)
+    {
+        // 记录按8字节对齐，剩余部分至少能放下一个填充标记
+        uint32_t padding = kPadding;
+        ::memcpy(data + offset, &padding, sizeof padding);
+        offset = 0;
+    }
+    pending = pos + need;
+    return data + offset;
+}
+
+void BinaryLog::threadFunc()
+{
+    while (!stopping_)
+    {
+        if (drain() == 0)
+        {
+            ::usleep(1000);
+        }
+    }
+    // stop之前已经提交的记录全部取走
+    drain();
+    if (file_)
+    {
+        ::fflush(file_);
+    }
+}
+
+size_t BinaryLog::drain()
+{
+    std::vector<ThreadRing *> rings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings = rings_;
+    }
+
+    size_t count = 0;
+    for (ThreadRing *ring : rings)
+    {
+        // 先读retired：线程已经退出时，之后读到的head就是最终值
+        bool retired = ring->retired.load(std::memory_order_acquire);
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        while (tail < head)
+        {
+            size_t offset = tail & (ThreadRing::kSize - 1);
+            const char *record = ring->data + offset;
+            uint32_t formatId;
+            ::memcpy(&formatId, record, sizeof formatId);
+            if (formatId == kPadding)
+            {
+                tail += ThreadRing::kSize - offset;
+                continue;
+            }
+            RecordHeader header;
+            ::memcpy(&header, record, sizeof header);
+            consume(record, header);
+            tail += header.length;
+            ++count;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+
+        if (retired)
+        {
+            retiredDropped_ += ring->dropped.load(std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                rings_.erase(std::find(rings_.begin(), rings_.end(), ring));
+            }
+            delete ring;
+        }
+    }
+    return count;
+}
+
+const BinaryLog::FormatInfo *BinaryLog::lookupFormat(uint32_t formatId)
+{
+    if (formatId >= cachedFormats_.size())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cachedFormats_ = formats_;
+    }
+    return formatId < cachedFormats_.size() ? &cachedFormats_[formatId]
+                                            : nullptr;
+}
+
+void BinaryLog::consume(const char *record, const RecordHeader &header)
+{
+    const FormatInfo *info = lookupFormat(header.formatId);
+    if (info == nullptr)
+    {
+        return;
+    }
+
+    if (file_)
+    {
+        // 二进制文件：第一次遇到某个格式串时先写字典项，记录本身原样写入
+        if (header.formatId >= written_.size())
+        {
+            written_.resize(header.formatId + 1, false);
+        }
+        if (!written_[header.formatId])
+        {
+            writeDictionary(header.formatId, *info);
+            written_[header.formatId] = true;
+        }
+        ::fwrite_unlocked(record, 1, header.length, file_);
+    }
+    else if (output_)
+    {
+        line_.clear();
+        formatRecord(*info, header, record + sizeof header,
+                     record + header.length, &line_);
+        output_(line_.data(), line_.size());
+    }
+}
+
+// 字典项: RecordHeader{kDictionary} + formatId + level + line + fmt\0 + file\0，按8字节对齐
+void BinaryLog::writeDictionary(uint32_t formatId, const FormatInfo &info)
+{
+    size_t fmtLen = ::strlen(info.fmt) + 1;
+    size_t fileLen = ::strlen(info.file) + 1;
+    size_t n = sizeof(RecordHeader) + 3 * sizeof(int32_t) + fmtLen + fileLen;
+    n = (n + 7) & ~static_cast<size_t>(7);
+
+    std::vector<char> buf(n, 0);
+    RecordHeader header{kDictionary, static_cast<uint32_t>(n), 0};
+    char *p = buf.data();
+    ::memcpy(p, &header, sizeof header);
+    p += sizeof header;
+    int32_t fields[3] = {static_cast<int32_t>(formatId),
+                         static_cast<int32_t>(info.level), info.line};
+    ::memcpy(p, fields, sizeof fields);
+    p += sizeof fields;
+    ::memcpy(p, info.fmt, fmtLen);
+    p += fmtLen;
+    ::memcpy(p, info.file, fileLen);
+    ::fwrite_unlocked(buf.data(), 1, n, file_);
+}
+
+void BinaryLog::formatRecord(const FormatInfo &info, const RecordHeader &header,
+                             const char *args, const char *end,
+                             std::string *out)
+{
+    // 时间精确到微秒
+    char buf[64];
+    Timestamp(header.nanoSecondsSinceEpoch / 1000).formatTo(buf, sizeof buf);
+    out->append(levelName(info.level));
+    out->append(buf);
+    out->append(" : ");
+
+    // 逐个解析格式串中的转换说明，每次只用一个参数调用snprintf
+    // 整数的长度修饰符统一替换成ll，因为记录里的整数都是64位的
+    const char *fmt = info.fmt;
+    while (*fmt)
+    {
+        if (*fmt != '%')
+        {
+            out->push_back(*fmt++);
+            continue;
+        }
+        if (fmt[1] == '%')
+        {
+            out->push_back('%');
+            fmt += 2;
+            continue;
+        }
+
+        std::string spec("%");
+        ++fmt;
+        while (*fmt && ::strchr("-+ #0123456789.", *fmt))
+        {
+            spec.push_back(*fmt++);
+        }
+        while (*fmt && ::strchr("hljztqL", *fmt))
+        {
+            ++fmt;
+        }
+        char conv = *fmt;
+        if (conv == '\0')
+        {
+            break;
+        }
+        ++fmt;
+
+        // 参数比转换说明少（或者记录损坏）时输出<?>
+        uint8_t type = args < end ? static_cast<uint8_t>(*args) : 0xff;
+        size_t fixed = type == kString ? sizeof(uint32_t) : sizeof(uint64_t);
+        if (args + 1 + fixed > end)
+        {
+            out->append("<?>");
+            args = end;
+            continue;
+        }
+        ++args;
+        char value[kMaxStringArg + 64];
+        int n = 0;
+        if (type == kString)
+        {
+            uint32_t len;
+            ::memcpy(&len, args, sizeof len);
+            args += sizeof len;
+            std::string str(args, std::min<size_t>(len, end - args));
+            args += len;
+            spec.push_back('s');
+            n = snprintf(value, sizeof value, spec.c_str(), str.c_str());
+        }
+        else
+        {
+            uint64_t raw;
+            ::memcpy(&raw, args, sizeof raw);
+            args += sizeof raw;
+            if (::strchr("fFeEgGaA", conv))
+            {
+                double d;
+                if (type == kDouble)
+                {
+                    ::memcpy(&d, &raw, sizeof d);
+                }
+                else
+                {
+                    d = static_cast<double>(static_cast<int64_t>(raw));
+                }
+                spec.push_back(conv);
+                n = snprintf(value, sizeof value, spec.c_str(), d);
+            }
+            else if (conv == 'p')
+            {
+                spec.push_back('p');
+                n = snprintf(value, sizeof value, spec.c_str(),
+                             reinterpret_cast<void *>(raw));
+            }
+            else if (conv == 'c')
+            {
+                spec.push_back('c');
+                n = snprintf(value, sizeof value, spec.c_str(),
+                             static_cast<int>(raw));
+            }
+            else if (conv == 'd' || conv == 'i')
+            {
+                spec += "ll";
+                spec.push_back(conv);
+                n = snprintf(value, sizeof value, spec.c_str(),
+                             static_cast<long long>(raw));
+            }
+            else
+            {
+                spec += "ll";
+                spec.push_back(conv);
+                n = snprintf(value, sizeof value, spec.c_str(),
+                             static_cast<unsigned long long>(raw));
+            }
+        }
+        if (n > 0)
+        {
+            out->append(value, std::min<size_t>(n, sizeof value - 1));
+        }
+    }
+
+    // 调用点的格式串常常自带换行
+    if (out->empty() || out->back() != '\n')
+    {
+        out->push_back('\n');
+    }
+}
+
+long BinaryLog::decodeFile(const std::string &path, OutputFunc output)
+{
+    FILE *fp = ::fopen(path.c_str(), "re");
+    if (!fp)
+    {
+        return -1;
+    }
+
+    std::vector<FormatInfo> formats;
+    std::deque<std::string> strings; // formats中的指针指向这里
+    std::vector<char> buf;
+    std::string line;
+    long count = 0;
+    RecordHeader header;
+    while (::fread(&header, 1, sizeof header, fp) == sizeof header)
+    {
+        if (header.length < sizeof header || header.length > ThreadRing::kSize)
+        {
+            count = -1;
+            break;
+        }
+        buf.resize(header.length - sizeof header);
+        if (::fread(buf.data(), 1, buf.size(), fp) != buf.size())
+        {
+            count = -1;
+            break;
+        }
+
+        if (header.formatId == kDictionary)
+        {
+            int32_t fields[3];
+            if (buf.size() < sizeof fields)
+            {
+                count = -1;
+                break;
+            }
+            ::memcpy(fields, buf.data(), sizeof fields);
+            const char *p = buf.data() + sizeof fields;
+            const char *end = buf.data() + buf.size();
+            size_t fmtLen = ::strnlen(p, end - p);
+            strings.emplace_back(p, fmtLen);
+            const char *fmt = strings.back().c_str();
+            p = std::min(p + fmtLen + 1, end);
+            strings.emplace_back(p, ::strnlen(p, end - p));
+            const char *file = strings.back().c_str();
+
+            size_t id = static_cast<uint32_t>(fields[0]);
+            if (id >= formats.size())
+            {
+                formats.resize(id + 1, FormatInfo{INFO, 0, "", ""});
+            }
+            formats[id] = FormatInfo{static_cast<LogLevel>(fields[1]),
+                                     fields[2], fmt, file};
+            continue;
+        }
+
+        if (header.formatId >= formats.size())
+        {
+            count = -1;
+            break;
+        }
+        line.clear();
+        formatRecord(formats[header.formatId], header, buf.data(),
+                     buf.data() + buf.size(), &line);
+        output(line.data(), line.size());
+        ++count;
+    }
+    ::fclose(fp);
+    return count;
+}
+} // namespace myMuduo
@@ -0,0 +1,92 @@
+#include "BlockPool.h"
+
+namespace myMuduo
+{
+BlockPool::BlockPool(size_t maxCachedBlocks)
+    : maxCachedBlocks_(maxCachedBlocks), ownerTid_(CurrentThread::tid()),
+      localBlocks_(0), remoteBlocks_(0)
+{
+}
+
+// 最后一个分配器释放时析构，此时已经没有其他线程在使用池子
+BlockPool::~BlockPool()
+{
+    for (auto &item : freeLists_)
+    {
+        for (void *p : item.second)
+        {
+            ::operator delete(p);
+        }
+    }
+    for (const RemoteBlock &block : remoteFree_)
+    {
+        ::operator delete(block.p);
+    }
+}
+
+void *BlockPool::allocate(size_t size)
+{
+    if (!isOwnerThread())
+    {
+        return ::operator new(size);
+    }
+
+    auto it = freeLists_.find(size);
+    if ((it == freeLists_.end() || it->second.empty()) &&
+        remoteBlocks_.load(std::memory_order_relaxed) > 0)
+    {
+        drainRemote();
+        it = freeLists_.find(size);
+    }
+    if (it != freeLists_.end() && !it->second.empty())
+    {
+        void *p = it->second.back();
+        it->second.pop_back();
+        localBlocks_.fetch_sub(1, std::memory_order_relaxed);
+        return p;
+    }
+    return ::operator new(size);
+}
+
+void BlockPool::deallocate(void *p, size_t size)
+{
+    // 上限只是大致的，本地和远程的计数不需要严格一致
+    size_t cached = localBlocks_.load(std::memory_order_relaxed) +
+                    remoteBlocks_.load(std::memory_order_relaxed);
+    if (cached < maxCachedBlocks_)
+    {
+        if (isOwnerThread())
+        {
+            freeLists_[size].push_back(p);
+            localBlocks_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        remoteFree_.push_back(RemoteBlock{p, size});
+        remoteBlocks_.store(remoteFree_.size(), std::memory_order_relaxed);
+        return;
+    }
+    ::operator delete(p);
+}
+
+void BlockPool::drainRemote()
+{
+    std::vector<RemoteBlock> blocks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blocks.swap(remoteFree_);
+        remoteBlocks_.store(0, std::memory_order_relaxed);
+    }
+    for (const RemoteBlock &block : blocks)
+    {
+        freeLists_[block.size].push_back(block.p);
+    }
+    localBlocks_.fetch_add(blocks.size(), std::memory_order_relaxed);
+}
+
+size_t BlockPool::cachedBlocks() const
+{
+    return localBlocks_.load(std::memory_order_relaxed) +
+           remoteBlocks_.load(std::memory_order_relaxed);
+}
+} // namespace myMuduo
@@ -38,7 +38,7 @@ ssize_t Buffer::readFd(int fd, int *saveErrno)
     // extrabuf也写了数据
     else
     {
-        writerIndex_ = buffer_.size();
+        writerIndex_ += writable;
         // 将数据追加到vec[0]写入带缓冲区的数据后
         append(extrabuf, n - writable);
     }
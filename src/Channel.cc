@@ -57,7 +57,7 @@ void Channel::handleEvent(Timestamp receiveTime)
 // 根据poller通知的channel发生的事件执行相应的回调操作
 void Channel::handleEventWithGuard(Timestamp receiveTime)
 {
-    LOG_INFO("Channel handleEvent revents:%d\n", revents_);
+    LOG_DEBUG("Channel handleEvent revents:%d\n", revents_);
     // 关闭
     /*
     EPOLLHUP表示对端已经关闭连接（如TCP连接中收到FIN包）。
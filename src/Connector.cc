@@ -0,0 +1,267 @@
+#include "Connector.h"
+#include "Channel.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <random>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace myMuduo
+{
+static int createNonblocking(sa_family_t family)
+{
+    int sockfd =
+        ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sockfd < 0)
+    {
+        LOG_FATAL("%s:%s:%d connect socket create err:%d \n", __FILE__,
+                  __func__, __LINE__, errno);
+    }
+    return sockfd;
+}
+
+// 非阻塞connect的结果保存在SO_ERROR中
+static int getSocketError(int sockfd)
+{
+    int optval = 0;
+    socklen_t optlen = sizeof optval;
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0)
+    {
+        return errno;
+    }
+    return optval;
+}
+
+// 连接本机、目标端口又恰好是内核分配的临时端口时，socket可能连上自己（TCP同时打开）
+static bool isSelfConnect(int sockfd)
+{
+    sockaddr_storage local;
+    sockaddr_storage peer;
+    socklen_t len = sizeof local;
+    memset(&local, 0, sizeof local);
+    memset(&peer, 0, sizeof peer);
+    if (::getsockname(sockfd, (sockaddr *)&local, &len) < 0)
+    {
+        return false;
+    }
+    len = sizeof peer;
+    if (::getpeername(sockfd, (sockaddr *)&peer, &len) < 0)
+    {
+        return false;
+    }
+    if (local.ss_family == AF_INET)
+    {
+        const sockaddr_in *l = reinterpret_cast<const sockaddr_in *>(&local);
+        const sockaddr_in *p = reinterpret_cast<const sockaddr_in *>(&peer);
+        return l->sin_port == p->sin_port &&
+               l->sin_addr.s_addr == p->sin_addr.s_addr;
+    }
+    if (local.ss_family == AF_INET6)
+    {
+        const sockaddr_in6 *l = reinterpret_cast<const sockaddr_in6 *>(&local);
+        const sockaddr_in6 *p = reinterpret_cast<const sockaddr_in6 *>(&peer);
+        return l->sin6_port == p->sin6_port &&
+               memcmp(&l->sin6_addr, &p->sin6_addr, sizeof l->sin6_addr) == 0;
+    }
+    // Unix域socket不会连上自己
+    return false;
+}
+
+// 实际等待时间在[delay/2, delay)之间随机，大量客户端同时断开时不会在同一时刻一起重连
+static double jitter(double delay)
+{
+    thread_local std::mt19937 gen(std::random_device{}());
+    std::uniform_real_distribution<double> dist(0.5, 1.0);
+    return delay * dist(gen);
+}
+
+Connector::Connector(EventLoop *loop, const InetAddress &serverAddr)
+    : loop_(loop), serverAddr_(serverAddr), connect_(false),
+      state_(kDisconnected), retryDelay_(kInitRetryDelay)
+{
+}
+
+Connector::~Connector()
+{
+    if (channel_)
+    {
+        LOG_ERROR("Connector::dtor - connecting to %s is still in progress \n",
+                  serverAddr_.toIpPort().c_str());
+    }
+}
+
+void Connector::start()
+{
+    connect_ = true;
+    loop_->runInLoop(std::bind(&Connector::startInLoop, shared_from_this()));
+}
+
+void Connector::startInLoop()
+{
+    loop_->assertInLoopThread();
+    // 重试的定时器到期前可能已经stop
+    if (connect_ && state_ == kDisconnected)
+    {
+        connect();
+    }
+}
+
+void Connector::restart()
+{
+    loop_->assertInLoopThread();
+    setState(kDisconnected);
+    retryDelay_ = kInitRetryDelay;
+    connect_ = true;
+    startInLoop();
+}
+
+void Connector::stop()
+{
+    connect_ = false;
+    loop_->queueInLoop(std::bind(&Connector::stopInLoop, shared_from_this()));
+}
+
+void Connector::stopInLoop()
+{
+    loop_->assertInLoopThread();
+    if (state_ == kConnecting)
+    {
+        setState(kDisconnected);
+        ::close(removeAndResetChannel());
+    }
+}
+
+void Connector::connect()
+{
+    int sockfd = createNonblocking(serverAddr_.family());
+    int ret = ::connect(sockfd, serverAddr_.getSockAddr(),
+                        serverAddr_.getSockLen());
+    int savedErrno = (ret == 0) ? 0 : errno;
+    switch (savedErrno)
+    {
+        // 连接正在进行，等待socket可写
+        case 0:
+        case EINPROGRESS:
+        case EINTR:
+        case EISCONN:
+            connecting(sockfd);
+            break;
+
+        // 暂时性的错误，稍后重试
+        case EAGAIN:
+        case EADDRINUSE:
+        case EADDRNOTAVAIL:
+        case ECONNREFUSED:
+        case ENETUNREACH:
+        case ENOENT: // Unix域socket的服务器还没有创建socket文件
+            retry(sockfd);
+            break;
+
+        // 地址或者参数错误，重试也不会成功
+        default:
+            LOG_ERROR("Connector::connect - connect %s err:%d \n",
+                      serverAddr_.toIpPort().c_str(), savedErrno);
+            ::close(sockfd);
+            break;
+    }
+}
+
+void Connector::connecting(int sockfd)
+{
+    setState(kConnecting);
+    channel_.reset(new Channel(loop_, sockfd));
+    channel_->setWriteCallBack([this]() { handleWrite(); });
+    channel_->setErrorCallBack([this]() { handleError(); });
+    // 连接完成（成功或失败）时socket变为可写
+    channel_->enableWriting();
+}
+
+// 把channel从poller中移除，返回sockfd，之后由调用者负责这个fd
+int Connector::removeAndResetChannel()
+{
+    channel_->disableAll();
+    channel_->remove();
+    int sockfd = channel_->fd();
+    // 当前可能正在channel_自己的回调中，不能马上析构，留到本轮事件处理完之后
+    std::shared_ptr<Channel> channel(std::move(channel_));
+    loop_->queueInLoop([channel]() {});
+    return sockfd;
+}
+
+void Connector::handleWrite()
+{
+    if (state_ != kConnecting)
+    {
+        return;
+    }
+
+    int sockfd = removeAndResetChannel();
+    int err = getSocketError(sockfd);
+    if (err)
+    {
+        LOG_ERROR("Connector::handleWrite - connect %s SO_ERROR = %d %s \n",
+                  serverAddr_.toIpPort().c_str(), err, strerror(err));
+        retry(sockfd);
+    }
+    else if (isSelfConnect(sockfd))
+    {
+        LOG_ERROR("Connector::handleWrite - self connect to %s \n",
+                  serverAddr_.toIpPort().c_str());
+        retry(sockfd);
+    }
+    else
+    {
+        setState(kConnected);
+        if (connect_)
+        {
+            newConnectionCallBack_(sockfd);
+        }
+        else
+        {
+            ::close(sockfd);
+        }
+    }
+}
+
+void Connector::handleError()
+{
+    if (state_ == kConnecting)
+    {
+        int sockfd = removeAndResetChannel();
+        int err = getSocketError(sockfd);
+        LOG_ERROR("Connector::handleError - connect %s SO_ERROR = %d %s \n",
+                  serverAddr_.toIpPort().c_str(), err, strerror(err));
+        retry(sockfd);
+    }
+}
+
+void Connector::retry(int sockfd)
+{
+    ::close(sockfd);
+    setState(kDisconnected);
+    if (!connect_)
+    {
+        return;
+    }
+
+    double delay = jitter(retryDelay_);
+    LOG_INFO("Connector::retry - retry connecting to %s in %.2f seconds \n",
+             serverAddr_.toIpPort().c_str(), delay);
+    // 定时器不能取消，到期时Connector可能已经析构
+    std::weak_ptr<Connector> weakSelf(shared_from_this());
+    loop_->runAfter(delay,
+                    [weakSelf]()
+                    {
+                        std::shared_ptr<Connector> self = weakSelf.lock();
+                        if (self)
+                        {
+                            self->startInLoop();
+                        }
+                    });
+    retryDelay_ = std::min(retryDelay_ * 2, kMaxRetryDelay);
+}
+} // namespace myMuduo
@@ -1,5 +1,7 @@
 #include "CurrentThread.h"
 
+#include <pthread.h>
+
 namespace myMuduo::CurrentThread
 {
 thread_local int t_cachedTid = 0;
@@ -8,8 +10,24 @@ void cacheTid()
 {
     if (t_cachedTid == 0)
     {
-        // 通过linux系统调用获取当前线程pid值
-        t_cachedTid = static_cast<pid_t>(::syscall(SYS_getpid));
+        // 通过linux系统调用获取当前线程的tid，每个线程各不相同（getpid在所有线程中都一样）
+        t_cachedTid = static_cast<pid_t>(::syscall(SYS_gettid));
     }
 }
-} // namespace myMuduo::CurrentThread
\ No newline at end of file
+
+namespace
+{
+// fork出的子进程中，调用fork的线程的tid变了，清掉缓存重新获取
+void afterForkInChild() { t_cachedTid = 0; }
+
+struct ForkHandlerRegistrar
+{
+    ForkHandlerRegistrar()
+    {
+        ::pthread_atfork(nullptr, nullptr, &afterForkInChild);
+    }
+};
+
+ForkHandlerRegistrar forkHandlerRegistrar;
+} // namespace
+} // namespace myMuduo::CurrentThread
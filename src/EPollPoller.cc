@@ -31,7 +31,7 @@ EPollPoller::~EPollPoller() { ::close(epollfd_); }
 Timestamp EPollPoller::poll(int timeoutMs, ChannelList *activateChannels)
 {
     // 使用LOG_DEBUG，只有在DEBUG时候才会输出日志，避免正式使用的时候高并发时poll性能慢
-    LOG_INFO("func=%s => fd total count:%lu\n", __func__, channels_.size());
+    LOG_DEBUG("func=%s => fd total count:%lu\n", __func__, channels_.size());
 
     int numEvents = ::epoll_wait(epollfd_, &*events_.begin(),
                                  static_cast<int>(events_.size()), timeoutMs);
@@ -42,7 +42,7 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList *activateChannels)
 
     if (numEvents > 0)
     {
-        LOG_INFO("%d events happened\n", numEvents);
+        LOG_DEBUG("%d events happened\n", numEvents);
         fillActiveChannels(numEvents, activateChannels);
         if (numEvents == events_.size())
         {
@@ -83,8 +83,9 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList *activateChannels)
 */
 void EPollPoller::updateChannel(Channel *channel)
 {
+    assertInLoopThread();
     const int index = channel->index();
-    LOG_INFO("func=%s => fd=%d events=%d index=%d\n", __func__, channel->fd(),
+    LOG_DEBUG("func=%s => fd=%d events=%d index=%d\n", __func__, channel->fd(),
              channel->events(), index);
 
     if (index == kNew || index == kDeleted)
@@ -117,8 +118,9 @@ void EPollPoller::updateChannel(Channel *channel)
 // 从Poller中删除channel
 void EPollPoller::removeChannel(Channel *channel)
 {
+    assertInLoopThread();
     int fd = channel->fd();
-    LOG_INFO("func=%s => fd=%d\n", __func__, fd);
+    LOG_DEBUG("func=%s => fd=%d\n", __func__, fd);
 
     channels_.erase(fd);
 
@@ -2,6 +2,7 @@
 #include "Channel.h"
 #include "Logger.h"
 #include "Poller.h"
+#include "TimerQueue.h"
 
 #include <errno.h>
 #include <fcntl.h>
@@ -32,7 +33,9 @@ int createEventfd()
 EventLoop::EventLoop()
     : looping_(false), quit_(false), callingPendingFunctors_(false),
       threadId_(CurrentThread::tid()), poller_(Poller::newDefaultPoller(this)),
-      wakeupFd_(createEventfd()), wakeupChannel_(new Channel(this, wakeupFd_))
+      connectionPool_(std::make_shared<BlockPool>()),
+      wakeupFd_(createEventfd()), wakeupChannel_(new Channel(this, wakeupFd_)),
+      timerQueue_(new TimerQueue(this))
 {
     LOG_DEBUG("EventLoop created %p in thread %d \n", this, threadId_);
     if (t_loopInThisThread)
@@ -94,6 +97,8 @@ void EventLoop::loop()
             wakeup subloop后，执行下面的方法，执行之前mainloop注册的cb操作
         */
         doPendingFunctors();
+        // 本轮循环中合并起来的操作（如auto cork的发送）统一在最后执行
+        doIterationEndFunctors();
     }
     LOG_INFO("EventLoop %p stop looping. \n", this);
 }
@@ -125,7 +130,7 @@ void EventLoop::runInLoop(Functor cb)
     }
     else // 在非当前loop线程中执行cb,需要唤醒loop所在线程，执行cb
     {
-        queueInLoop(cb);
+        queueInLoop(std::move(cb));
     }
 }
 
@@ -134,7 +139,7 @@ void EventLoop::queueInLoop(Functor cb)
 {
     {
         std::unique_lock<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb);
+        pendingFunctors_.emplace_back(std::move(cb));
     }
 
     // 唤醒相应的，需要执行上面回调操作的loop的线程了
@@ -147,6 +152,21 @@ void EventLoop::queueInLoop(Functor cb)
     }
 }
 
+void EventLoop::runAtIterationEnd(Functor cb)
+{
+    iterationEndFunctors_.emplace_back(std::move(cb));
+}
+
+void EventLoop::runAfter(double seconds, Functor cb)
+{
+    TimerQueue::Clock::time_point when =
+        TimerQueue::Clock::now() +
+        std::chrono::duration_cast<TimerQueue::Clock::duration>(
+            std::chrono::duration<double>(seconds));
+    runInLoop([this, when, cb = std::move(cb)]() mutable
+              { timerQueue_->addTimer(when, std::move(cb)); });
+}
+
 // 唤醒loop所在的线程，用wakefd_写入一个数据,wakeupChannel就发生读事件，当前loop线程就会被唤醒
 void EventLoop::wakeup()
 {
@@ -161,19 +181,29 @@ void EventLoop::wakeup()
 // EventLoop的方法，调用Poller方法
 void EventLoop::updateChannel(Channel *channel)
 {
+    assertInLoopThread();
     poller_->updateChannel(channel);
 }
 
 void EventLoop::removeChannel(Channel *channel)
 {
+    assertInLoopThread();
     poller_->removeChannel(channel);
 }
 
 bool EventLoop::hasChannel(Channel *channel)
 {
+    assertInLoopThread();
     return poller_->hasChannel(channel);
 }
 
+void EventLoop::abortNotInLoopThread() const
+{
+    LOG_FATAL("EventLoop::abortNotInLoopThread - EventLoop %p was created in "
+              "threadId_ = %d, current thread id = %d \n",
+              this, threadId_, CurrentThread::tid());
+}
+
 // 执行回调
 void EventLoop::doPendingFunctors()
 {
@@ -193,4 +223,18 @@ void EventLoop::doPendingFunctors()
 
     callingPendingFunctors_ = false;
 }
+
+void EventLoop::doIterationEndFunctors()
+{
+    // 回调中如果调用了queueInLoop，需要唤醒下一轮poll，否则要等到超时才能执行
+    callingPendingFunctors_ = true;
+    // 回调中新注册的cb留到下一轮循环，如暂停读取的连接每轮检查一次是否可以恢复
+    std::vector<Functor> functors;
+    functors.swap(iterationEndFunctors_);
+    for (const Functor &functor : functors)
+    {
+        functor();
+    }
+    callingPendingFunctors_ = false;
+}
 } // namespace myMuduo
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "InetAddress.h"
+#include "Logger.h"
 
+#include <algorithm>
+#include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 #include <strings.h>
 
@@ -8,38 +12,157 @@ namespace myMuduo
 InetAddress::InetAddress(uint16_t port, std::string ip)
 {
     bzero(&addr_, sizeof addr_);
-    addr_.sin_family = AF_INET;
-    addr_.sin_port = htons(port); // 本地字节序转为网络字节序
-    addr_.sin_addr.s_addr = inet_addr(ip.c_str());
+    if (ip.find(':') != std::string::npos)
+    {
+        sockaddr_in6 *addr6 = reinterpret_cast<sockaddr_in6 *>(&addr_);
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(port);
+        if (::inet_pton(AF_INET6, ip.c_str(), &addr6->sin6_addr) != 1)
+        {
+            LOG_FATAL("InetAddress - invalid ipv6 address %s \n", ip.c_str());
+        }
+        len_ = sizeof(sockaddr_in6);
+    }
+    else
+    {
+        sockaddr_in *addr4 = reinterpret_cast<sockaddr_in *>(&addr_);
+        addr4->sin_family = AF_INET;
+        addr4->sin_port = htons(port); // 本地字节序转为网络字节序
+        if (::inet_pton(AF_INET, ip.c_str(), &addr4->sin_addr) != 1)
+        {
+            LOG_FATAL("InetAddress - invalid ipv4 address %s \n", ip.c_str());
+        }
+        len_ = sizeof(sockaddr_in);
+    }
+}
+
+InetAddress::InetAddress(const sockaddr_in &addr)
+{
+    setSockAddr(reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+}
+
+InetAddress::InetAddress(const sockaddr_in6 &addr)
+{
+    setSockAddr(reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+}
+
+InetAddress::InetAddress(const sockaddr *addr, socklen_t len)
+{
+    setSockAddr(addr, len);
+}
+
+InetAddress InetAddress::fromUnixPath(const std::string &path)
+{
+    sockaddr_un addr;
+    bzero(&addr, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    // 截断后的路径会bind/connect到另一个地址，直接当作配置错误
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        LOG_FATAL("InetAddress - unix socket path too long: %s \n",
+                  path.c_str());
+    }
+    size_t n = path.size();
+    memcpy(addr.sun_path, path.data(), n);
+    // 抽象命名空间的地址以'\0'开头，长度以实际的名字为准，不包含结尾的'\0'
+    socklen_t len = offsetof(sockaddr_un, sun_path) + n + 1;
+    if (n > 0 && path[0] == '@')
+    {
+        addr.sun_path[0] = '\0';
+        len = offsetof(sockaddr_un, sun_path) + n;
+    }
+    return InetAddress(reinterpret_cast<const sockaddr *>(&addr), len);
+}
+
+void InetAddress::setSockAddr(const sockaddr *addr, socklen_t len)
+{
+    bzero(&addr_, sizeof addr_);
+    len_ = std::min<socklen_t>(len, sizeof addr_);
+    memcpy(&addr_, addr, len_);
 }
 
 std::string InetAddress::toIp() const
 {
-    char buf[64] = {0};
-    ::inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof buf);
+    char buf[INET6_ADDRSTRLEN] = {0};
+    if (family() == AF_INET6)
+    {
+        const sockaddr_in6 *addr6 = reinterpret_cast<const sockaddr_in6 *>(&addr_);
+        ::inet_ntop(AF_INET6, &addr6->sin6_addr, buf, sizeof buf);
+    }
+    else if (family() == AF_INET)
+    {
+        const sockaddr_in *addr4 = reinterpret_cast<const sockaddr_in *>(&addr_);
+        ::inet_ntop(AF_INET, &addr4->sin_addr, buf, sizeof buf);
+    }
     return buf;
 }
 
 std::string InetAddress::toIpPort() const
 {
-    // ip:port
-    char buf[64] = {0};
-    ::inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof buf);
-    size_t end = strlen(buf);
-    uint16_t port = ntohs(addr_.sin_port);
-    sprintf(buf + end, ":%u", port);
-    return buf;
+    char buf[kMaxStringLength];
+    size_t n = formatTo(buf, sizeof buf);
+    return std::string(buf, n);
 }
 
-uint16_t InetAddress::toPort() const { return ntohs(addr_.sin_port); }
-} // namespace myMuduo
-
-// #include <iostream>
-
-// int main()
-// {
-//     myMuduo::InetAddress addr(8080);
-//     std::cout << addr.toIpPort() << std::endl;
+size_t InetAddress::formatTo(char *buf, size_t size) const
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    buf[0] = '\0';
+    int n = 0;
+    if (family() == AF_INET)
+    {
+        // ip:port
+        const sockaddr_in *addr4 = reinterpret_cast<const sockaddr_in *>(&addr_);
+        char ip[INET_ADDRSTRLEN] = {0};
+        ::inet_ntop(AF_INET, &addr4->sin_addr, ip, sizeof ip);
+        n = snprintf(buf, size, "%s:%u", ip, ntohs(addr4->sin_port));
+    }
+    else if (family() == AF_INET6)
+    {
+        // [ip]:port
+        const sockaddr_in6 *addr6 = reinterpret_cast<const sockaddr_in6 *>(&addr_);
+        char ip[INET6_ADDRSTRLEN] = {0};
+        ::inet_ntop(AF_INET6, &addr6->sin6_addr, ip, sizeof ip);
+        n = snprintf(buf, size, "[%s]:%u", ip, ntohs(addr6->sin6_port));
+    }
+    else if (family() == AF_UNIX)
+    {
+        const sockaddr_un *un = reinterpret_cast<const sockaddr_un *>(&addr_);
+        size_t pathLen = len_ > offsetof(sockaddr_un, sun_path)
+                             ? len_ - offsetof(sockaddr_un, sun_path)
+                             : 0;
+        if (pathLen == 0)
+        {
+            // accept返回的客户端一般没有bind，地址为空
+            n = snprintf(buf, size, "unix:");
+        }
+        else if (un->sun_path[0] == '\0')
+        {
+            n = snprintf(buf, size, "unix:@%.*s", static_cast<int>(pathLen - 1),
+                         un->sun_path + 1);
+        }
+        else
+        {
+            n = snprintf(buf, size, "unix:%.*s", static_cast<int>(pathLen),
+                         un->sun_path);
+        }
+    }
+    return n < 0 ? 0 : std::min(static_cast<size_t>(n), size - 1);
+}
 
-//     return 0;
-// }
\ No newline at end of file
+uint16_t InetAddress::toPort() const
+{
+    if (family() == AF_INET6)
+    {
+        return ntohs(reinterpret_cast<const sockaddr_in6 *>(&addr_)->sin6_port);
+    }
+    if (family() == AF_INET)
+    {
+        return ntohs(reinterpret_cast<const sockaddr_in *>(&addr_)->sin_port);
+    }
+    return 0;
+}
+} // namespace myMuduo
@@ -0,0 +1,235 @@
+#include "LengthHeaderCodec.h"
+#include "Logger.h"
+#include "TcpConnection.h"
+
+#include <algorithm>
+#include <endian.h>
+#include <string.h>
+
+namespace myMuduo
+{
+// 头部能表示的最大消息长度
+static size_t maxLengthOf(LengthHeaderCodec::HeaderType type)
+{
+    switch (type)
+    {
+        case LengthHeaderCodec::kFixed16:
+            return UINT16_MAX;
+        case LengthHeaderCodec::kFixed32:
+            return UINT32_MAX;
+        default:
+            return SIZE_MAX;
+    }
+}
+
+LengthHeaderCodec::LengthHeaderCodec(FrameCallBack cb,
+                                     HeaderType type,
+                                     size_t maxFrameSize)
+    : frameCallBack_(std::move(cb)), type_(type),
+      maxFrameSize_(std::min(maxFrameSize, maxLengthOf(type)))
+{
+    errorCallBack_ = [](const TcpConnectionPtr &conn, const char *reason)
+    {
+        LOG_ERROR("LengthHeaderCodec - %s from %s, close connection \n", reason,
+                  conn->name().c_str());
+        conn->forceClose();
+    };
+}
+
+size_t LengthHeaderCodec::encodeHeader(char *out, uint64_t frameLen) const
+{
+    switch (type_)
+    {
+        case kFixed16:
+        {
+            uint16_t be = htobe16(static_cast<uint16_t>(frameLen));
+            memcpy(out, &be, sizeof be);
+            return sizeof be;
+        }
+        case kFixed32:
+        {
+            uint32_t be = htobe32(static_cast<uint32_t>(frameLen));
+            memcpy(out, &be, sizeof be);
+            return sizeof be;
+        }
+        case kFixed64:
+        {
+            uint64_t be = htobe64(frameLen);
+            memcpy(out, &be, sizeof be);
+            return sizeof be;
+        }
+        case kVarint:
+        default:
+        {
+            size_t n = 0;
+            while (frameLen >= 0x80)
+            {
+                out[n++] = static_cast<char>((frameLen & 0x7f) | 0x80);
+                frameLen >>= 7;
+            }
+            out[n++] = static_cast<char>(frameLen);
+            return n;
+        }
+    }
+}
+
+int LengthHeaderCodec::decodeHeader(const char *data,
+                                    size_t len,
+                                    uint64_t *frameLen) const
+{
+    switch (type_)
+    {
+        case kFixed16:
+        {
+            if (len < sizeof(uint16_t))
+            {
+                return 0;
+            }
+            uint16_t be;
+            memcpy(&be, data, sizeof be);
+            *frameLen = be16toh(be);
+            return sizeof be;
+        }
+        case kFixed32:
+        {
+            if (len < sizeof(uint32_t))
+            {
+                return 0;
+            }
+            uint32_t be;
+            memcpy(&be, data, sizeof be);
+            *frameLen = be32toh(be);
+            return sizeof be;
+        }
+        case kFixed64:
+        {
+            if (len < sizeof(uint64_t))
+            {
+                return 0;
+            }
+            uint64_t be;
+            memcpy(&be, data, sizeof be);
+            *frameLen = be64toh(be);
+            return sizeof be;
+        }
+        case kVarint:
+        default:
+        {
+            uint64_t value = 0;
+            for (size_t i = 0; i < len && i < kMaxHeaderLength; ++i)
+            {
+                uint8_t byte = static_cast<uint8_t>(data[i]);
+                value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+                if ((byte & 0x80) == 0)
+                {
+                    *frameLen = value;
+                    return static_cast<int>(i + 1);
+                }
+                // 还没有读完头部，长度就已经超过上限
+                if (value > maxFrameSize_)
+                {
+                    return -1;
+                }
+            }
+            return len >= kMaxHeaderLength ? -1 : 0;
+        }
+    }
+}
+
+void LengthHeaderCodec::onMessage(const TcpConnectionPtr &conn,
+                                  Buffer *buf,
+                                  Timestamp receiveTime)
+{
+    // 只移动本地的偏移，所有完整的消息都回调完后再一次retrieve
+    const char *data = buf->peek();
+    size_t readable = buf->readableBytes();
+    size_t offset = 0;
+    while (offset < readable)
+    {
+        uint64_t frameLen = 0;
+        int headerLen = decodeHeader(data + offset, readable - offset, &frameLen);
+        if (headerLen == 0)
+        {
+            break;
+        }
+        if (headerLen < 0 || frameLen > maxFrameSize_)
+        {
+            buf->retrieveAll();
+            errorCallBack_(conn, headerLen < 0 ? "invalid length header"
+                                               : "frame too large");
+            return;
+        }
+        if (readable - offset - headerLen < frameLen)
+        {
+            break; // 消息体还不完整
+        }
+        frameCallBack_(conn,
+                       std::string_view(data + offset + headerLen, frameLen),
+                       receiveTime);
+        offset += headerLen + frameLen;
+    }
+    buf->retrieve(offset);
+}
+
+bool LengthHeaderCodec::checkFrameSize(size_t frameLen) const
+{
+    // 超过上限的长度头部可能表示不了，对端也会把它当作错误关闭连接
+    if (frameLen > maxFrameSize_)
+    {
+        LOG_ERROR("LengthHeaderCodec - frame size %lu exceeds max frame size %lu \n",
+                  frameLen, maxFrameSize_);
+        return false;
+    }
+    return true;
+}
+
+bool LengthHeaderCodec::send(const TcpConnectionPtr &conn, Buffer *buf) const
+{
+    if (!checkFrameSize(buf->readableBytes()))
+    {
+        return false;
+    }
+    char header[kMaxHeaderLength];
+    size_t n = encodeHeader(header, buf->readableBytes());
+    if (buf->readableBytes() > 0 && buf->prependableBytes() >= n)
+    {
+        buf->prepend(header, n);
+        conn->send(buf);
+    }
+    else
+    {
+        // 空消息，或者varint头部放不进预留空间
+        conn->sendv({std::string_view(header, n),
+                     std::string_view(buf->peek(), buf->readableBytes())});
+        buf->retrieveAll();
+    }
+    return true;
+}
+
+bool LengthHeaderCodec::send(const TcpConnectionPtr &conn,
+                             std::string_view frame) const
+{
+    if (!checkFrameSize(frame.size()))
+    {
+        return false;
+    }
+    char header[kMaxHeaderLength];
+    size_t n = encodeHeader(header, frame.size());
+    conn->sendv({std::string_view(header, n), frame});
+    return true;
+}
+
+bool LengthHeaderCodec::appendFrame(Buffer *out, std::string_view frame) const
+{
+    if (!checkFrameSize(frame.size()))
+    {
+        return false;
+    }
+    char header[kMaxHeaderLength];
+    size_t n = encodeHeader(header, frame.size());
+    out->ensureWritableBytes(n + frame.size());
+    out->append(header, n);
+    out->append(frame.data(), frame.size());
+    return true;
+}
+} // namespace myMuduo
@@ -0,0 +1,183 @@
+#include "ListenSocketHandoff.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace myMuduo
+{
+static bool fillUnixAddr(const std::string &path, sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr->sun_path))
+    {
+        LOG_ERROR("handoff path %s too long \n", path.c_str());
+        return false;
+    }
+    memcpy(addr->sun_path, path.c_str(), path.size());
+    return true;
+}
+
+ListenSocketHandoff::ListenSocketHandoff(EventLoop *loop,
+                                         const std::string &path,
+                                         int listenFd)
+    : loop_(loop), path_(path), listenFd_(listenFd), handoffFd_(-1)
+{
+}
+
+ListenSocketHandoff::~ListenSocketHandoff()
+{
+    // 已经交接过时path可能已经属于新进程，不能unlink
+    if (handoffFd_ >= 0)
+    {
+        channel_->disableAll();
+        channel_->remove();
+        ::close(handoffFd_);
+        ::unlink(path_.c_str());
+    }
+}
+
+void ListenSocketHandoff::start()
+{
+    sockaddr_un addr;
+    if (!fillUnixAddr(path_, &addr))
+    {
+        return;
+    }
+    handoffFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (handoffFd_ < 0)
+    {
+        LOG_ERROR("handoff socket create err:%d \n", errno);
+        return;
+    }
+    // 上一次升级留下的path已经没有进程在监听了
+    ::unlink(path_.c_str());
+    if (::bind(handoffFd_, reinterpret_cast<sockaddr *>(&addr), sizeof addr) <
+            0 ||
+        ::chmod(path_.c_str(), 0600) < 0 || ::listen(handoffFd_, 4) < 0)
+    {
+        LOG_ERROR("handoff listen on %s err:%d \n", path_.c_str(), errno);
+        ::close(handoffFd_);
+        handoffFd_ = -1;
+        return;
+    }
+
+    channel_.reset(new Channel(loop_, handoffFd_));
+    channel_->setReadCallBack([this](Timestamp) { handleRead(); });
+    channel_->enableReading();
+}
+
+void ListenSocketHandoff::handleRead()
+{
+    int connfd = ::accept4(handoffFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (connfd < 0)
+    {
+        LOG_ERROR("handoff accept err:%d \n", errno);
+        return;
+    }
+
+    // 只把监听fd交给同一个用户的进程
+    ucred cred;
+    socklen_t len = sizeof cred;
+    if (::getsockopt(connfd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0 ||
+        cred.uid != ::geteuid())
+    {
+        LOG_ERROR("handoff refused, peer uid mismatch \n");
+        ::close(connfd);
+        return;
+    }
+
+    char data = 'L';
+    iovec vec;
+    vec.iov_base = &data;
+    vec.iov_len = 1;
+
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof control);
+    msghdr msg = {};
+    msg.msg_iov = &vec;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &listenFd_, sizeof(int));
+
+    ssize_t n = ::sendmsg(connfd, &msg, MSG_NOSIGNAL);
+    ::close(connfd);
+    if (n != 1)
+    {
+        LOG_ERROR("handoff sendmsg err:%d \n", errno);
+        return;
+    }
+
+    LOG_INFO("listen fd=%d handed off to pid %d \n", listenFd_, cred.pid);
+    // 只交接一次，之后由新进程负责下一次升级
+    // channel_正在执行回调，不能在这里析构，只从poller中移除
+    channel_->disableAll();
+    channel_->remove();
+    ::close(handoffFd_);
+    handoffFd_ = -1;
+
+    if (handoffCallBack_)
+    {
+        handoffCallBack_();
+    }
+}
+
+int ListenSocketHandoff::receive(const std::string &path)
+{
+    sockaddr_un addr;
+    if (!fillUnixAddr(path, &addr))
+    {
+        return -1;
+    }
+    int sockfd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sockfd < 0)
+    {
+        return -1;
+    }
+    if (::connect(sockfd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) <
+        0)
+    {
+        // 没有旧进程，正常启动
+        ::close(sockfd);
+        return -1;
+    }
+
+    char data;
+    iovec vec;
+    vec.iov_base = &data;
+    vec.iov_len = 1;
+    char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg = {};
+    msg.msg_iov = &vec;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+
+    int listenFd = -1;
+    ssize_t n = ::recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (n == 1 && cmsg && cmsg->cmsg_level == SOL_SOCKET &&
+        cmsg->cmsg_type == SCM_RIGHTS)
+    {
+        memcpy(&listenFd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    else
+    {
+        LOG_ERROR("handoff receive from %s failed, err:%d \n", path.c_str(),
+                  errno);
+    }
+    ::close(sockfd);
+    return listenFd;
+}
+} // namespace myMuduo
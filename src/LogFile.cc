@@ -0,0 +1,135 @@
+#include "LogFile.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace myMuduo
+{
+LogFile::LogFile(const std::string &basename, off_t rollSize, int flushInterval)
+    : basename_(basename), rollSize_(rollSize), flushInterval_(flushInterval),
+      fp_(nullptr), writtenBytes_(0), count_(0), startOfPeriod_(0),
+      lastRoll_(0), lastFlush_(0)
+{
+    rollFile();
+}
+
+LogFile::~LogFile()
+{
+    if (fp_)
+    {
+        ::fclose(fp_);
+    }
+}
+
+void LogFile::append(const char *logline, size_t len)
+{
+    if (!fp_)
+    {
+        return;
+    }
+    // 只有后台线程写文件，不需要stdio内部的锁
+    size_t written = 0;
+    while (written < len)
+    {
+        size_t n = ::fwrite_unlocked(logline + written, 1, len - written, fp_);
+        if (n == 0)
+        {
+            // ferror只返回出错标志，具体原因要在fwrite之后马上保存errno
+            int savedErrno = errno;
+            if (::ferror(fp_))
+            {
+                fprintf(stderr, "LogFile::append() failed %s\n",
+                        strerror(savedErrno));
+            }
+            break;
+        }
+        written += n;
+    }
+    writtenBytes_ += written;
+
+    if (writtenBytes_ > rollSize_)
+    {
+        rollFile();
+    }
+    else if (++count_ >= kCheckTimeRoll)
+    {
+        count_ = 0;
+        time_t now = ::time(nullptr);
+        time_t thisPeriod = now / kRollPerSeconds * kRollPerSeconds;
+        if (thisPeriod != startOfPeriod_)
+        {
+            rollFile();
+        }
+        else if (now - lastFlush_ > flushInterval_)
+        {
+            lastFlush_ = now;
+            ::fflush(fp_);
+        }
+    }
+}
+
+void LogFile::flush()
+{
+    if (fp_)
+    {
+        ::fflush(fp_);
+    }
+}
+
+void LogFile::rollFile()
+{
+    time_t now = ::time(nullptr);
+    // 同一秒内滚动两次会得到同一个文件名，继续写当前文件
+    if (now <= lastRoll_ && fp_)
+    {
+        return;
+    }
+    std::string filename = logFileName(basename_, now);
+    lastRoll_ = now;
+    lastFlush_ = now;
+    startOfPeriod_ = now / kRollPerSeconds * kRollPerSeconds;
+
+    if (fp_)
+    {
+        ::fclose(fp_);
+    }
+    fp_ = ::fopen(filename.c_str(), "ae"); // e: O_CLOEXEC
+    if (!fp_)
+    {
+        fprintf(stderr, "LogFile: open %s failed, errno %d\n", filename.c_str(),
+                errno);
+        return;
+    }
+    ::setvbuf(fp_, buffer_, _IOFBF, sizeof buffer_);
+    writtenBytes_ = 0;
+}
+
+std::string LogFile::logFileName(const std::string &basename, time_t now)
+{
+    std::string filename = basename;
+
+    char timebuf[32];
+    struct tm tm;
+    ::gmtime_r(&now, &tm);
+    ::strftime(timebuf, sizeof timebuf, ".%Y%m%d-%H%M%S.", &tm);
+    filename += timebuf;
+
+    char hostname[256];
+    if (::gethostname(hostname, sizeof hostname) == 0)
+    {
+        hostname[sizeof hostname - 1] = '\0';
+        filename += hostname;
+    }
+    else
+    {
+        filename += "unknownhost";
+    }
+
+    char pidbuf[32];
+    snprintf(pidbuf, sizeof pidbuf, ".%d", ::getpid());
+    filename += pidbuf;
+    filename += ".log";
+    return filename;
+}
+} // namespace myMuduo
@@ -1,10 +1,18 @@
 #include "Logger.h"
 #include "Timestamp.h"
 
-#include <iostream>
+#include <stdio.h>
 
 namespace myMuduo
 {
+namespace
+{
+// 默认输出到stdout，由stdio缓冲，不再每条日志都flush
+void defaultOutput(const char *msg, size_t len) { ::fwrite(msg, 1, len, stdout); }
+
+void defaultFlush() { ::fflush(stdout); }
+} // namespace
+
 // 获取日志唯一的实例对象
 Logger &Logger::instance()
 {
@@ -12,32 +20,55 @@ Logger &Logger::instance()
     return logger;
 }
 
-// 设置日志级别
-void Logger::setLogLevel(int level) { logLevel_ = level; }
-
 // 写日志  打印格式:      [级别] time ： msg
-void Logger::log(const std::string &msg)
+void Logger::log(LogLevel level, const char *msg)
 {
-    switch (logLevel_)
+    const char *levelName = "";
+    switch (level)
     {
         case INFO:
-            std::cout << "[INFO]";
+            levelName = "[INFO]";
             break;
         case ERROR:
-            std::cout << "[ERROR]";
+            levelName = "[ERROR]";
             break;
         case FATAL:
-            std::cout << "[FATAL]";
+            levelName = "[FATAL]";
+            break;
         case DEBUG:
-            std::cout << "[DEBUG]";
+            levelName = "[DEBUG]";
             break;
         default:
             break;
     }
 
-    // 打印时间
-    std::cout << Timestamp::now().toString() << " : " << msg << std::endl;
+    // 整条日志先格式化到栈上，一次交给output_，异步后端按条追加
+    char buf[1280];
+    char timebuf[64];
+    Timestamp::now().formatTo(timebuf, sizeof timebuf);
+    int n = snprintf(buf, sizeof buf, "%s%s : %s\n", levelName, timebuf, msg);
+    if (n < 0)
+    {
+        return;
+    }
+    size_t len = static_cast<size_t>(n);
+    if (len >= sizeof buf)
+    {
+        // 被截断的日志也要以换行结尾
+        len = sizeof buf - 1;
+        buf[len - 1] = '\n';
+    }
+    output_(buf, len);
+
+    // FATAL之后进程马上退出，先把缓冲的日志写出去
+    if (level == FATAL)
+    {
+        flush_();
+    }
 }
 
-Logger::Logger() {}
-} // namespace myMuduo
\ No newline at end of file
+Logger::Logger()
+    : output_(defaultOutput), flush_(defaultFlush)
+{
+}
+} // namespace myMuduo
@@ -0,0 +1,7 @@
+#include "OutputBudget.h"
+
+namespace myMuduo
+{
+std::atomic<size_t> OutputBudget::limit_{0};
+std::atomic<size_t> OutputBudget::used_{0};
+} // namespace myMuduo
@@ -0,0 +1,265 @@
+#include "OutputQueue.h"
+#include "OutputBudget.h"
+
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace myMuduo
+{
+OutputQueue::~OutputQueue() { OutputBudget::release(memoryBytes_ + pinnedBytes_); }
+
+void OutputQueue::append(const char *data, size_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+    // 和队尾的拷贝段合并，连续拷贝的数据在buffer_中本来就是连续的
+    if (segments_.empty() || !segments_.back().data.empty() ||
+        segments_.back().file)
+    {
+        segments_.push_back(Segment{SharedBuffer(), 0, nullptr, 0});
+    }
+    segments_.back().len += len;
+    buffer_.append(data, len);
+    readableBytes_ += len;
+    memoryBytes_ += len;
+    OutputBudget::charge(len);
+}
+
+void OutputQueue::append(const SharedBuffer &buf)
+{
+    if (buf.empty())
+    {
+        return;
+    }
+    segments_.push_back(Segment{buf, buf.size(), nullptr, 0});
+    readableBytes_ += buf.size();
+    memoryBytes_ += buf.size();
+    OutputBudget::charge(buf.size());
+}
+
+void OutputQueue::appendFile(int fd, off_t offset, size_t len)
+{
+    // 最后一个引用该fd的文件段释放时关闭fd
+    std::shared_ptr<int> file(new int(fd),
+                              [](int *fd)
+                              {
+                                  ::close(*fd);
+                                  delete fd;
+                              });
+    if (len == 0)
+    {
+        return;
+    }
+    segments_.push_back(Segment{SharedBuffer(), len, file, offset});
+    readableBytes_ += len;
+}
+
+void OutputQueue::retrieve(size_t len)
+{
+    size_t released = 0;
+    while (len > 0 && !segments_.empty())
+    {
+        Segment &seg = segments_[head_];
+        size_t n = std::min(len, seg.len);
+        if (seg.file)
+        {
+            seg.offset += n;
+        }
+        else if (seg.data.empty())
+        {
+            buffer_.retrieve(n);
+        }
+        else
+        {
+            seg.data = seg.data.slice(n, seg.len - n);
+        }
+        seg.len -= n;
+        len -= n;
+        readableBytes_ -= n;
+        if (!seg.file)
+        {
+            released += n;
+        }
+        // 这一段已经全部发送完，释放对SharedBuffer的引用
+        if (seg.len == 0)
+        {
+            popFront();
+        }
+    }
+    memoryBytes_ -= released;
+    OutputBudget::release(released);
+}
+
+void OutputQueue::popFront()
+{
+    segments_[head_] = Segment{SharedBuffer(), 0, nullptr, 0};
+    ++head_;
+    if (head_ == segments_.size())
+    {
+        // 队列空了，保留vector的容量给后面的数据
+        segments_.clear();
+        head_ = 0;
+    }
+    else if (head_ >= kCompactSegments && head_ * 2 >= segments_.size())
+    {
+        // 一直没有发空时，前面已经发送完的段占了一半以上，挪掉它们
+        segments_.erase(segments_.begin(), segments_.begin() + head_);
+        head_ = 0;
+    }
+}
+
+void OutputQueue::retrieveAll()
+{
+    buffer_.retrieveAll();
+    segments_.clear();
+    head_ = 0;
+    readableBytes_ = 0;
+    OutputBudget::release(memoryBytes_);
+    memoryBytes_ = 0;
+}
+
+ssize_t OutputQueue::writeFd(int fd, int *saveErrno)
+{
+    if (!segments_.empty() && segments_[head_].file)
+    {
+        Segment &seg = segments_[head_];
+        off_t offset = seg.offset;
+        ssize_t n = ::sendfile(fd, *seg.file, &offset,
+                               std::min(seg.len, kMaxFileChunk));
+        if (n < 0)
+        {
+            *saveErrno = errno;
+            // EAGAIN之外的错误（EIO、EINVAL等）重试也不会成功，丢弃这个文件段
+            if (*saveErrno != EAGAIN)
+            {
+                retrieve(seg.len);
+            }
+        }
+        else if (n == 0)
+        {
+            // 文件比调用者给出的长度短，剩下的部分已经无法发送，对端会一直等下去，按出错处理
+            retrieve(seg.len);
+            *saveErrno = ENODATA;
+            n = -1;
+        }
+        return n;
+    }
+
+    if (zeroCopyThreshold_ > 0 && !segments_.empty() &&
+        !segments_[head_].data.empty() &&
+        segments_[head_].len >= zeroCopyThreshold_)
+    {
+        ssize_t n = writeZeroCopy(fd, saveErrno);
+        // ENOBUFS说明超过了optmem限制，这一次退回普通的拷贝发送
+        if (n >= 0 || *saveErrno != ENOBUFS)
+        {
+            return n;
+        }
+    }
+
+    struct iovec vec[kMaxIovecs];
+    int iovcnt = 0;
+    // 拷贝段在buffer_中是按顺序连续存放的，buffered指向下一个拷贝段的起始位置
+    const char *buffered = buffer_.peek();
+    for (size_t i = head_; i < segments_.size(); ++i)
+    {
+        const Segment &seg = segments_[i];
+        // 文件段之前的内存数据先用writev发出，文件段留给下一次调用
+        if (iovcnt == kMaxIovecs || seg.file)
+        {
+            break;
+        }
+        if (seg.data.empty())
+        {
+            vec[iovcnt].iov_base = const_cast<char *>(buffered);
+            buffered += seg.len;
+        }
+        else
+        {
+            vec[iovcnt].iov_base = const_cast<char *>(seg.data.data());
+        }
+        vec[iovcnt].iov_len = seg.len;
+        ++iovcnt;
+    }
+
+    ssize_t n = ::writev(fd, vec, iovcnt);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+    return n;
+}
+
+// 只发送队头连续的SharedBuffer段，buffer_中的数据随时可能被移动，不能零拷贝发送
+ssize_t OutputQueue::writeZeroCopy(int fd, int *saveErrno)
+{
+    struct iovec vec[kMaxIovecs];
+    int iovcnt = 0;
+    for (size_t i = head_; i < segments_.size(); ++i)
+    {
+        const Segment &seg = segments_[i];
+        if (iovcnt == kMaxIovecs || seg.file || seg.data.empty())
+        {
+            break;
+        }
+        vec[iovcnt].iov_base = const_cast<char *>(seg.data.data());
+        vec[iovcnt].iov_len = seg.len;
+        ++iovcnt;
+    }
+
+    struct msghdr msg = {};
+    msg.msg_iov = vec;
+    msg.msg_iovlen = iovcnt;
+    ssize_t n = ::sendmsg(fd, &msg, MSG_ZEROCOPY);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+        return n;
+    }
+
+    // 内核引用的是用户态的内存，收到完成通知之前要一直持有这些数据，
+    // retrieve会把它们从预算中扣除，这里重新计入，完成时再扣除
+    PinnedSend send{nextZeroCopyId_++, {}, static_cast<size_t>(n)};
+    size_t pinned = 0;
+    for (size_t i = head_; i < segments_.size(); ++i)
+    {
+        const Segment &seg = segments_[i];
+        if (pinned >= static_cast<size_t>(n))
+        {
+            break;
+        }
+        send.data.push_back(seg.data);
+        pinned += seg.len;
+    }
+    pinnedBytes_ += send.len;
+    OutputBudget::charge(send.len);
+    pinned_.push_back(std::move(send));
+    return n;
+}
+
+void OutputQueue::zeroCopyCompleted(uint32_t lo, uint32_t hi)
+{
+    size_t released = 0;
+    // 编号是32位循环计数，用差值判断是否落在[lo, hi]中
+    for (auto it = pinned_.begin(); it != pinned_.end();)
+    {
+        if (static_cast<int32_t>(it->id - lo) >= 0 &&
+            static_cast<int32_t>(hi - it->id) >= 0)
+        {
+            released += it->len;
+            it = pinned_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    pinnedBytes_ -= released;
+    OutputBudget::release(released);
+}
+} // namespace myMuduo
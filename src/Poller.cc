@@ -1,11 +1,14 @@
 #include "Poller.h"
 #include "Channel.h"
 #include "EPollPoller.h"
+#include "EventLoop.h"
 
 namespace myMuduo
 {
 Poller::Poller(EventLoop *loop) : ownerLoop_(loop) {}
 
+void Poller::assertInLoopThread() const { ownerLoop_->assertInLoopThread(); }
+
 bool Poller::hasChannel(Channel *channel) const
 {
     auto it = channels_.find(channel->fd());
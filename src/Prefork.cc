@@ -0,0 +1,130 @@
+#include "Prefork.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace myMuduo
+{
+Prefork::Prefork(int numWorkers, WorkerFunc func)
+    : numWorkers_(numWorkers), func_(std::move(func)),
+      workers_(numWorkers, Worker{-1, 0}), stopping_(false)
+{
+}
+
+void Prefork::run()
+{
+    // master只在sigwaitinfo中同步处理信号，fork之前先屏蔽，避免worker启动前被打断
+    sigset_t mask, oldMask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    ::sigprocmask(SIG_BLOCK, &mask, &oldMask);
+
+    for (int i = 0; i < numWorkers_; ++i)
+    {
+        spawn(i);
+    }
+
+    while (true)
+    {
+        siginfo_t info;
+        int signo = ::sigwaitinfo(&mask, &info);
+        if (signo == SIGCHLD)
+        {
+            if (!reap())
+            {
+                break;
+            }
+        }
+        else if ((signo == SIGTERM || signo == SIGINT) && !stopping_)
+        {
+            LOG_INFO("master %d stopping, forward SIGTERM to workers \n",
+                     ::getpid());
+            stopping_ = true;
+            for (const Worker &worker : workers_)
+            {
+                if (worker.pid > 0)
+                {
+                    ::kill(worker.pid, SIGTERM);
+                }
+            }
+        }
+    }
+
+    ::sigprocmask(SIG_SETMASK, &oldMask, nullptr);
+    LOG_INFO("master %d exit, all workers stopped \n", ::getpid());
+}
+
+void Prefork::spawn(int index)
+{
+    // 日志默认由stdio缓冲，fork之前先写出去，否则缓冲区被复制到worker中会重复输出
+    ::fflush(nullptr);
+    pid_t pid = ::fork();
+    if (pid < 0)
+    {
+        LOG_ERROR("fork worker %d err:%d \n", index, errno);
+        return;
+    }
+    if (pid == 0)
+    {
+        // worker恢复默认的信号屏蔽字，需要信号时自己用SignalWatcher监听
+        sigset_t empty;
+        sigemptyset(&empty);
+        ::sigprocmask(SIG_SETMASK, &empty, nullptr);
+        int status = func_(index);
+        // _exit不会刷新stdio缓冲区，worker最后的日志要先写出去
+        ::fflush(nullptr);
+        ::_exit(status);
+    }
+    workers_[index] = Worker{pid, ::time(nullptr)};
+    LOG_INFO("master %d spawned worker %d pid %d \n", ::getpid(), index, pid);
+}
+
+bool Prefork::reap()
+{
+    pid_t pid;
+    int status;
+    while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        for (int i = 0; i < numWorkers_; ++i)
+        {
+            Worker &worker = workers_[i];
+            if (worker.pid != pid)
+            {
+                continue;
+            }
+            worker.pid = -1;
+            bool crashed = WIFSIGNALED(status) ||
+                           (WIFEXITED(status) && WEXITSTATUS(status) != 0);
+            if (!crashed || stopping_)
+            {
+                LOG_INFO("worker %d pid %d exited \n", i, pid);
+                break;
+            }
+            LOG_ERROR("worker %d pid %d crashed (status %d), restarting \n", i,
+                      pid, status);
+            if (::time(nullptr) - worker.startTime < kMinWorkerLifetime)
+            {
+                ::sleep(kMinWorkerLifetime);
+            }
+            spawn(i);
+            break;
+        }
+    }
+
+    for (const Worker &worker : workers_)
+    {
+        if (worker.pid > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace myMuduo
@@ -0,0 +1,53 @@
+#include "SignalWatcher.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+namespace myMuduo
+{
+static int createSignalfd(int signo)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, signo);
+    // 信号必须先屏蔽，否则会按默认方式处理而不会出现在signalfd上
+    ::pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    int fd = ::signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_FATAL("signalfd error:%d \n", errno);
+    }
+    return fd;
+}
+
+SignalWatcher::SignalWatcher(EventLoop *loop, int signo, SignalCallBack cb)
+    : signo_(signo), signalFd_(createSignalfd(signo)),
+      channel_(loop, signalFd_), callback_(std::move(cb))
+{
+    channel_.setReadCallBack([this](Timestamp) { handleRead(); });
+    channel_.enableReading();
+}
+
+SignalWatcher::~SignalWatcher()
+{
+    channel_.disableAll();
+    channel_.remove();
+    ::close(signalFd_);
+}
+
+void SignalWatcher::handleRead()
+{
+    signalfd_siginfo info;
+    while (::read(signalFd_, &info, sizeof info) == sizeof info)
+    {
+        if (callback_)
+        {
+            callback_(signo_);
+        }
+    }
+}
+} // namespace myMuduo
@@ -14,8 +14,7 @@ Socket::~Socket() { ::close(sockfd_); }
 
 void Socket::bindAddress(const InetAddress &localaddr)
 {
-    if (0 != ::bind(sockfd_, (sockaddr *)(localaddr.getSockAddr()),
-                    sizeof(sockaddr_in)))
+    if (0 != ::bind(sockfd_, localaddr.getSockAddr(), localaddr.getSockLen()))
     {
         LOG_FATAL("bind sockfd:%d fail \n", sockfd_);
     }
@@ -31,14 +30,14 @@ void Socket::listen()
 
 int Socket::accept(InetAddress *peeraddr)
 {
-    sockaddr_in addr;
+    sockaddr_storage addr;
     socklen_t len = sizeof(addr);
     memset(&addr, 0, sizeof(addr));
     int connfd = ::accept4(sockfd_, (sockaddr *)&addr, &len,
                            SOCK_NONBLOCK | SOCK_CLOEXEC);
     if (connfd >= 0)
     {
-        peeraddr->setSockAddr(addr);
+        peeraddr->setSockAddr((sockaddr *)&addr, len);
     }
     return connfd;
 }
@@ -58,6 +57,13 @@ void Socket::setTcpNoDelay(bool on)
     ::setsockopt(sockfd_, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
 }
 
+// 打开后内核攒满一个MSS才发送，关闭时立即发出剩余的数据
+void Socket::setTcpCork(bool on)
+{
+    int optval = on ? 1 : 0;
+    ::setsockopt(sockfd_, IPPROTO_TCP, TCP_CORK, &optval, sizeof(optval));
+}
+
 void Socket::setReuseAddr(bool on)
 {
     int optval = on ? 1 : 0;
@@ -75,4 +81,11 @@ void Socket::setKeepAlive(bool on)
     int optval = on ? 1 : 0;
     ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval));
 }
+
+bool Socket::setZeroCopy(bool on)
+{
+    int optval = on ? 1 : 0;
+    return ::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &optval,
+                        sizeof(optval)) == 0;
+}
 } // namespace myMuduo
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "SplicePipe.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace myMuduo
+{
+SplicePipe::SplicePipe() : size_(0), capacity_(0)
+{
+    if (::pipe2(fds_, O_NONBLOCK | O_CLOEXEC) < 0)
+    {
+        LOG_ERROR("SplicePipe create err:%d \n", errno);
+        fds_[0] = fds_[1] = -1;
+        return;
+    }
+    // 增大管道容量，失败时使用默认容量（一般为64KB）
+    ::fcntl(fds_[1], F_SETPIPE_SZ, kPipeSize);
+    int size = ::fcntl(fds_[1], F_GETPIPE_SZ);
+    capacity_ = size > 0 ? size : 64 * 1024;
+}
+
+SplicePipe::~SplicePipe()
+{
+    if (valid())
+    {
+        ::close(fds_[0]);
+        ::close(fds_[1]);
+    }
+}
+
+ssize_t SplicePipe::readFd(int fd, int *saveErrno)
+{
+    ssize_t n = ::splice(fd, nullptr, fds_[1], nullptr, capacity_ - size_,
+                         SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+    else
+    {
+        size_ += n;
+    }
+    return n;
+}
+
+ssize_t SplicePipe::writeFd(int fd, int *saveErrno)
+{
+    ssize_t n = ::splice(fds_[0], nullptr, fd, nullptr, size_,
+                         SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+    else
+    {
+        size_ -= n;
+    }
+    return n;
+}
+} // namespace myMuduo
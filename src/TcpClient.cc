@@ -0,0 +1,138 @@
+#include "TcpClient.h"
+#include "BlockPool.h"
+#include "Buffer.h"
+#include "Connector.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <functional>
+
+namespace myMuduo
+{
+// TcpClient析构后连接才关闭时使用，不再访问TcpClient
+static void removeDetachedConnection(const TcpConnectionPtr &conn)
+{
+    conn->getloop()->queueInLoop(
+        std::bind(&TcpConnection::connectDestoryed, conn));
+}
+
+TcpClient::TcpClient(EventLoop *loop,
+                     const InetAddress &serverAddr,
+                     const std::string &name)
+    : loop_(loop), connector_(std::make_shared<Connector>(loop, serverAddr)),
+      name_(name), handlers_(std::make_shared<ConnectionHandlers>()),
+      retry_(false), connect_(false), nextConnId_(1)
+{
+    handlers_->name = name_ + "-" + serverAddr.toIpPort();
+    // 用户没有设置时使用的默认回调
+    handlers_->connectionCallBack = [](const TcpConnectionPtr &) {};
+    handlers_->messageCallBack = [](const TcpConnectionPtr &, Buffer *buf,
+                                    Timestamp) { buf->retrieveAll(); };
+    // 关闭连接的回调，不是由用户设置的
+    handlers_->closeCallBack = [this](const TcpConnectionPtr &conn)
+    { removeConnection(conn); };
+
+    connector_->setNewConnectionCallBack(
+        std::bind(&TcpClient::newConnection, this, std::placeholders::_1));
+}
+
+TcpClient::~TcpClient()
+{
+    TcpConnectionPtr conn;
+    bool unique = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unique = connection_.use_count() == 1;
+        conn = connection_;
+    }
+
+    if (conn)
+    {
+        // 连接可能比TcpClient活得更久，关闭时不能再回调removeConnection
+        loop_->runInLoop(
+            [conn]() { conn->setCloseCallBack(removeDetachedConnection); });
+        // 没有其他地方持有这个连接，直接关闭
+        if (unique)
+        {
+            conn->forceClose();
+        }
+    }
+    else
+    {
+        connector_->stop();
+    }
+}
+
+ConnectionHandlers &TcpClient::mutableHandlers()
+{
+    // 已经建立的连接还在使用旧表，拷贝一份再修改
+    if (handlers_.use_count() > 1)
+    {
+        handlers_ = std::make_shared<ConnectionHandlers>(*handlers_);
+    }
+    return *handlers_;
+}
+
+void TcpClient::connect()
+{
+    LOG_INFO("TcpClient::connect [%s] - connecting to %s \n", name_.c_str(),
+             connector_->serverAddress().toIpPort().c_str());
+    connect_ = true;
+    connector_->start();
+}
+
+void TcpClient::disconnect()
+{
+    connect_ = false;
+    TcpConnectionPtr conn = connection();
+    if (conn)
+    {
+        conn->shutdown();
+    }
+}
+
+void TcpClient::stop()
+{
+    connect_ = false;
+    connector_->stop();
+}
+
+TcpConnectionPtr TcpClient::connection() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connection_;
+}
+
+void TcpClient::newConnection(int sockfd)
+{
+    loop_->assertInLoopThread();
+    uint64_t id = nextConnId_++;
+    // 和TcpServer的连接一样从loop的对象池分配
+    TcpConnectionPtr conn = std::allocate_shared<TcpConnection>(
+        PoolAllocator<TcpConnection>(loop_->connectionPool()), loop_, id, sockfd,
+        connector_->serverAddress());
+    conn->setHandlers(handlers_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_ = conn;
+    }
+    conn->connectEstablished();
+}
+
+void TcpClient::removeConnection(const TcpConnectionPtr &conn)
+{
+    loop_->assertInLoopThread();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_.reset();
+    }
+    loop_->queueInLoop(std::bind(&TcpConnection::connectDestoryed, conn));
+
+    if (retry_ && connect_)
+    {
+        LOG_INFO("TcpClient::removeConnection [%s] - reconnecting to %s \n",
+                 name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+        connector_->restart();
+    }
+}
+} // namespace myMuduo
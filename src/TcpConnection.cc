@@ -2,14 +2,20 @@
 #include "Channel.h"
 #include "EventLoop.h"
 #include "Logger.h"
+#include "OutputBudget.h"
 #include "Socket.h"
+#include "SplicePipe.h"
 
 #include <errno.h>
 #include <functional>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace myMuduo
@@ -25,34 +31,73 @@ static EventLoop *checkLoopNotNull(EventLoop *loop)
     return loop;
 }
 
+// 所有没有设置过回调的连接共享这一张空表
+static const std::shared_ptr<const ConnectionHandlers> &defaultHandlers()
+{
+    static const std::shared_ptr<const ConnectionHandlers> handlers =
+        std::make_shared<ConnectionHandlers>();
+    return handlers;
+}
+
 TcpConnection::TcpConnection(EventLoop *loop,
-                             const std::string &name,
+                             uint64_t id,
                              int sockfd,
-                             const InetAddress &localAddr,
                              const InetAddress &peerAddr)
-    : loop_(checkLoopNotNull(loop)), name_(name), state_(kConnecting),
-      reading_(true), socket_(new Socket(sockfd)),
-      channel_(new Channel(loop, sockfd)), localAddr_(localAddr),
-      peerAddr_(peerAddr), highWaterMark_(64 * 1024 * 1024) // 64M
+    : loop_(checkLoopNotNull(loop)), id_(id), state_(kConnecting),
+      reading_(true), inputPaused_(false), outputPaused_(false),
+      aboveHighWaterMark_(false), autoCork_(false), flushPending_(false),
+      writeShutdown_(false), peerClosed_(false), socket_(sockfd), channel_(loop, sockfd), peerAddr_(peerAddr),
+      handlers_(defaultHandlers()), inputHighWaterMark_(0),
+      inputLowWaterMark_(0), inputBuffer_(0)
 {
     // 下面给channel设置相应的回调函数，poller给channel通知感兴趣的事件发生了，channel会回调相应的函数
-    channel_->setReadCallBack(
-        std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
+    // 只捕获this的lambda可以放进std::function的内部存储，不需要额外分配内存
+    channel_.setReadCallBack([this](Timestamp receiveTime)
+                             { handleRead(receiveTime); });
 
-    channel_->setWriteCallBack(std::bind(&TcpConnection::handleWrite, this));
+    channel_.setWriteCallBack([this]() { handleWrite(); });
 
-    channel_->setCloseCallBack(std::bind(&TcpConnection::handleClose, this));
+    channel_.setCloseCallBack([this]() { handleClose(); });
 
-    channel_->setErrorCallBack(std::bind(&TcpConnection::handleError, this));
+    channel_.setErrorCallBack([this]() { handleError(); });
 
-    LOG_INFO("TcpConnection::ctor[%s] at fd=%d\n", name_.c_str(), sockfd);
-    socket_->setKeepAlive(true);
+    LOG_INFO("TcpConnection::ctor[#%lu] at fd=%d\n", id_, sockfd);
+    socket_.setKeepAlive(true);
 }
 
 TcpConnection::~TcpConnection()
 {
-    LOG_INFO("TcpConnection::dtor[%s] at fd=%d state=%d \n", name_.c_str(),
-             channel_->fd(), static_cast<int>(state_));
+    LOG_INFO("TcpConnection::dtor[%s] at fd=%d state=%d \n", name().c_str(),
+             channel_.fd(), static_cast<int>(state_));
+}
+
+std::string TcpConnection::name() const
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "#%lu", id_);
+    return handlers_->name + buf;
+}
+
+InetAddress TcpConnection::localAddress() const
+{
+    sockaddr_storage local;
+    memset(&local, 0, sizeof(local));
+    socklen_t addrlen = sizeof(local);
+    if (::getsockname(channel_.fd(), (sockaddr *)&local, &addrlen))
+    {
+        LOG_ERROR("sockets::getLocalAddr");
+    }
+    return InetAddress((sockaddr *)&local, addrlen);
+}
+
+ConnectionHandlers &TcpConnection::mutableHandlers()
+{
+    // 表被其他连接共享时先拷贝，写时复制
+    if (handlers_.use_count() > 1)
+    {
+        handlers_ = std::make_shared<ConnectionHandlers>(*handlers_);
+    }
+    return const_cast<ConnectionHandlers &>(*handlers_);
 }
 
 void TcpConnection::send(const std::string &buf)
@@ -65,8 +110,150 @@ void TcpConnection::send(const std::string &buf)
         }
         else
         {
-            loop_->runInLoop(std::bind(&TcpConnection::sendInLoop, this,
-                                       buf.c_str(), buf.size()));
+            // buf可能在loop线程执行前就被释放，所以这里必须拷贝一份
+            send(std::string(buf));
+        }
+    }
+}
+
+void TcpConnection::send(std::string &&buf)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            size_t threshold = outputQueue_.zeroCopyThreshold();
+            if (threshold > 0 && buf.size() >= threshold)
+            {
+                // 零拷贝发送需要在完成前持有数据，直接接管buf，不拷贝
+                sendInLoop(SharedBuffer(std::move(buf)));
+            }
+            else
+            {
+                sendInLoop(buf.c_str(), buf.size());
+            }
+        }
+        else
+        {
+            // 数据的所有权移动到回调中，shared_from_this保证执行时连接还存在
+            loop_->queueInLoop(
+                [conn = shared_from_this(), msg = std::move(buf)]() mutable
+                { conn->send(std::move(msg)); });
+        }
+    }
+}
+
+void TcpConnection::send(const void *data, size_t len)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendInLoop(data, len);
+        }
+        else
+        {
+            send(std::string(static_cast<const char *>(data), len));
+        }
+    }
+}
+
+void TcpConnection::send(Buffer *buf)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendInLoop(buf->peek(), buf->readableBytes());
+            buf->retrieveAll();
+        }
+        else
+        {
+            // 交换出buf的内部存储交给loop线程，不拷贝数据
+            Buffer data(0);
+            data.swap(*buf);
+            loop_->queueInLoop(
+                [conn = shared_from_this(), data = std::move(data)]()
+                { conn->sendInLoop(data.peek(), data.readableBytes()); });
+        }
+    }
+}
+
+void TcpConnection::send(const SharedBuffer &buf)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendInLoop(buf);
+        }
+        else
+        {
+            // 只拷贝SharedBuffer本身，底层数据引用计数+1
+            loop_->queueInLoop([conn = shared_from_this(), buf]()
+                               { conn->sendInLoop(buf); });
+        }
+    }
+}
+
+void TcpConnection::sendv(std::initializer_list<std::string_view> pieces)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendvInLoop(pieces.begin(), pieces.size());
+        }
+        else
+        {
+            // 各段数据的生命周期只到本次调用结束，跨线程时只能拼接拷贝一次
+            std::string msg;
+            for (std::string_view piece : pieces)
+            {
+                msg.append(piece);
+            }
+            send(std::move(msg));
+        }
+    }
+}
+
+void TcpConnection::sendv(std::vector<SharedBuffer> pieces)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendvInLoop(pieces);
+        }
+        else
+        {
+            loop_->queueInLoop(
+                [conn = shared_from_this(), pieces = std::move(pieces)]()
+                { conn->sendvInLoop(pieces); });
+        }
+    }
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t length)
+{
+    if (state_ == kConnected)
+    {
+        // 在调用者线程中dup，调用者随后关闭自己的fd也不影响发送
+        int file = ::dup(fd);
+        if (file < 0)
+        {
+            LOG_ERROR("TcpConnection::sendFile dup fd=%d err:%d \n", fd, errno);
+            return;
+        }
+        if (loop_->isInLoopThread())
+        {
+            sendFileInLoop(file, offset, length);
+        }
+        else
+        {
+            loop_->queueInLoop(
+                [conn = shared_from_this(), file, offset, length]()
+                { conn->sendFileInLoop(file, offset, length); });
         }
     }
 }
@@ -76,81 +263,444 @@ void TcpConnection::send(const std::string &buf)
 */
 void TcpConnection::sendInLoop(const void *data, size_t len)
 {
-    ssize_t nwrote = 0;
-    size_t remaining = len;
-    bool faultError = false;
+    struct iovec vec = {const_cast<void *>(data), len};
+    size_t nwrote = 0;
+    if (!writeDirectly(&vec, 1, len, &nwrote))
+    {
+        return;
+    }
 
-    // 之前调用过该connection的shutdown，不能再进行发送了
-    if (state_ == kDisconnecting)
+    // 发送正常但没有一次发送完成,那么剩下的数据需要保存到缓冲区中，然后给channel注册epollout事件
+    // poller发现tcp的发送缓冲区有空间，会通知相应的sock（channel）调用handlewrite回调方法
+    // 最终调用TcpConnection::handleWrite方法，把发送缓冲区的数据全部发送完成
+    if (nwrote < len)
     {
-        LOG_ERROR("disconnected, give up writing!");
+        size_t oldlen = outputQueue_.readableBytes();
+        outputQueue_.append(static_cast<const char *>(data) + nwrote,
+                            len - nwrote);
+        outputQueued(oldlen);
+    }
+}
+
+// 和上面相同，只是剩下的数据以引用的方式放入发送队列，不拷贝
+void TcpConnection::sendInLoop(const SharedBuffer &buf)
+{
+    size_t threshold = outputQueue_.zeroCopyThreshold();
+    if (threshold > 0 && buf.size() >= threshold)
+    {
+        // 零拷贝只能通过发送队列发出，发送队列负责持有数据直到内核通知完成
+        if (state_ == kDisconnecting || state_ == kDisconnected)
+        {
+            LOG_ERROR("disconnected, give up writing!");
+            return;
+        }
+        bool idle = !channel_.isWriting() && outputQueue_.empty();
+        size_t oldlen = outputQueue_.readableBytes();
+        outputQueue_.append(buf);
+        queueOutput(oldlen, idle);
+        return;
+    }
+
+    struct iovec vec = {const_cast<char *>(buf.data()), buf.size()};
+    size_t nwrote = 0;
+    if (!writeDirectly(&vec, 1, buf.size(), &nwrote))
+    {
+        return;
+    }
+
+    if (nwrote < buf.size())
+    {
+        size_t oldlen = outputQueue_.readableBytes();
+        outputQueue_.append(buf.slice(nwrote, buf.size() - nwrote));
+        outputQueued(oldlen);
+    }
+}
+
+// 多段数据的发送，队列为空时用一次writev写出，剩下的部分拷贝到发送队列
+void TcpConnection::sendvInLoop(const std::string_view *pieces, size_t count)
+{
+    struct iovec vec[kMaxIovecs];
+    int iovcnt = static_cast<int>(std::min(count, kMaxIovecs));
+    for (int i = 0; i < iovcnt; ++i)
+    {
+        vec[i].iov_base = const_cast<char *>(pieces[i].data());
+        vec[i].iov_len = pieces[i].size();
+    }
+    // 段数超过kMaxIovecs时writev只写前面的部分，是否全部写完要按所有段的总长度判断
+    size_t totalLen = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        totalLen += pieces[i].size();
+    }
+    size_t nwrote = 0;
+    if (!writeDirectly(vec, iovcnt, totalLen, &nwrote))
+    {
+        return;
+    }
+
+    size_t oldlen = outputQueue_.readableBytes();
+    for (size_t i = 0; i < count; ++i)
+    {
+        // 跳过已经写入socket的部分
+        size_t skip = std::min(nwrote, pieces[i].size());
+        nwrote -= skip;
+        outputQueue_.append(pieces[i].data() + skip, pieces[i].size() - skip);
+    }
+    if (outputQueue_.readableBytes() > oldlen)
+    {
+        outputQueued(oldlen);
+    }
+}
+
+// 和上面相同，只是剩下的部分以引用的方式放入发送队列，不拷贝
+void TcpConnection::sendvInLoop(const std::vector<SharedBuffer> &pieces)
+{
+    struct iovec vec[kMaxIovecs];
+    int iovcnt = static_cast<int>(std::min(pieces.size(), kMaxIovecs));
+    for (int i = 0; i < iovcnt; ++i)
+    {
+        vec[i].iov_base = const_cast<char *>(pieces[i].data());
+        vec[i].iov_len = pieces[i].size();
+    }
+    size_t totalLen = 0;
+    for (const SharedBuffer &piece : pieces)
+    {
+        totalLen += piece.size();
+    }
+    size_t nwrote = 0;
+    if (!writeDirectly(vec, iovcnt, totalLen, &nwrote))
+    {
+        return;
+    }
+
+    size_t oldlen = outputQueue_.readableBytes();
+    for (const SharedBuffer &piece : pieces)
+    {
+        size_t skip = std::min(nwrote, piece.size());
+        nwrote -= skip;
+        outputQueue_.append(piece.slice(skip, piece.size() - skip));
+    }
+    if (outputQueue_.readableBytes() > oldlen)
+    {
+        outputQueued(oldlen);
+    }
+}
+
+// 文件段只能通过发送队列用sendfile发送，队列之前为空时立即开始发送
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length)
+{
+    if (state_ == kDisconnecting || state_ == kDisconnected)
+    {
+        LOG_ERROR("disconnected, give up sending file!");
+        ::close(fd);
         return;
     }
+
+    bool idle = !channel_.isWriting() && outputQueue_.empty();
+    size_t oldlen = outputQueue_.readableBytes();
+    outputQueue_.appendFile(fd, offset, length);
+    queueOutput(oldlen, idle);
+}
+
+// 数据已经追加到发送队列，idle表示追加之前没有待发送的数据，此时立即开始发送
+void TcpConnection::queueOutput(size_t oldlen, bool idle)
+{
+    if (idle && !autoCork_)
+    {
+        flushOutput();
+    }
+    // 直接发送没有写完时，剩下的数据同样要检查高水位和发送内存预算
+    if (outputQueue_.readableBytes() > oldlen)
+    {
+        outputQueued(oldlen);
+    }
+}
+
+// 发送队列为空时直接写socket，多段数据用writev一次写出，写入的字节数通过nwrote返回
+// totalLen是本次要发送的全部数据长度（可能多于vec中的数据），全部写完才回调writeComplete
+// 连接已关闭或者写出错时返回false，调用者应放弃本次发送
+bool TcpConnection::writeDirectly(const struct iovec *vec,
+                                  int iovcnt,
+                                  size_t totalLen,
+                                  size_t *nwrote)
+{
+    *nwrote = 0;
+    // 之前调用过该connection的shutdown，或者跨线程的发送任务执行前连接已断开，不能再进行发送了
+    if (state_ == kDisconnecting || state_ == kDisconnected)
+    {
+        LOG_ERROR("disconnected, give up writing!");
+        return false;
+    }
     // 表示channel第一次开始写数据，而且缓冲区没有待发送数据
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+    // auto cork模式下不直接写，数据全部进入发送队列，等本轮循环结束时一起发送
+    if (!autoCork_ && !channel_.isWriting() && outputQueue_.empty())
     {
-        nwrote = ::write(channel_->fd(), data, len);
+        size_t len = 0;
+        for (int i = 0; i < iovcnt; ++i)
+        {
+            len += vec[i].iov_len;
+        }
+        ssize_t n = iovcnt == 1 ? ::write(channel_.fd(), vec[0].iov_base, len)
+                                : ::writev(channel_.fd(), vec, iovcnt);
         // 发送成功
-        if (nwrote >= 0)
+        if (n >= 0)
         {
-            // remaing > 0说明没有一次发送完，即可能data长度超过一次能发送的长度
-            remaining = len - nwrote;
+            *nwrote = n;
             // 一次性写入完成
-            if (remaining == 0 && writeCompleteCallBack_)
+            if (*nwrote == totalLen && handlers_->writeCompleteCallBack)
             {
                 // 既然一次性发送完成了数据，就不用给channel设置epollout事件了
                 loop_->queueInLoop(
-                    std::bind(writeCompleteCallBack_, shared_from_this()));
+                    std::bind(handlers_->writeCompleteCallBack, shared_from_this()));
             }
         }
         else // 发送出错
         {
-            nwrote = 0;
             if (errno != EWOULDBLOCK)
             {
                 LOG_ERROR("TcpConnection::sendInLoop");
                 // 连接重置的请求
                 if (errno == EPIPE || errno == ECONNRESET)
                 {
-                    faultError = true;
+                    return false;
                 }
             }
         }
     }
+    return true;
+}
 
-    // 发送正常但没有一次发送完成,那么剩下的数据需要保存到缓冲区中，然后给channel注册epollout事件
-    // poller发现tcp的发送缓冲区有空间，会通知相应的sock（channel）调用handlewrite回调方法
-    // 最终调用TcpConnection::handleWrite方法，把发送缓冲区的数据全部发送完成
-    if (!faultError && remaining > 0)
+// 数据追加到发送队列之后调用，oldlen是追加之前队列中的数据长度
+void TcpConnection::outputQueued(size_t oldlen)
+{
+    size_t newlen = outputQueue_.readableBytes();
+    if (newlen >= handlers_->highWaterMark && oldlen < handlers_->highWaterMark)
     {
-        // 当前发送缓冲区剩余的待发送数据的长度
-        size_t oldlen = outputBuffer_.readableBytes();
-        if (oldlen + remaining >= highWaterMark_ && oldlen < highWaterMark_ &&
-            highWaterMarkCallBack_)
+        aboveHighWaterMark_ = true;
+        if (handlers_->highWaterMarkCallBack)
         {
-            loop_->queueInLoop(std::bind(highWaterMarkCallBack_,
-                                         shared_from_this(),
-                                         oldlen + remaining));
+            loop_->queueInLoop(
+                std::bind(handlers_->highWaterMarkCallBack, shared_from_this(), newlen));
         }
+    }
 
-        outputBuffer_.append((char *)data + nwrote, remaining);
-        if (!channel_->isWriting())
+    // 进程的发送内存超过预算时，暂停读取发送队列较大的连接，不让它继续产生响应
+    if (!outputPaused_ && OutputBudget::exceeded() &&
+        outputQueue_.memoryBytes() >=
+            std::max(handlers_->lowWaterMark, kMinBudgetPauseBytes))
+    {
+        LOG_ERROR("TcpConnection [%s] paused, output memory %lu over budget "
+                  "%lu \n",
+                  name().c_str(), OutputBudget::used(), OutputBudget::limit());
+        outputPaused_ = true;
+        updateReading();
+    }
+
+    if (autoCork_)
+    {
+        // 已经在等待EPOLLOUT的话由handleWrite发送，不需要再flush
+        if (!flushPending_ && !channel_.isWriting())
         {
-            // 一定要打开channel的些事件，否则poller不会给channel通知epollout
-            channel_->enableWriting();
+            flushPending_ = true;
+            loop_->runAtIterationEnd(
+                std::bind(&TcpConnection::flushOutput, shared_from_this()));
         }
     }
+    else if (!channel_.isWriting())
+    {
+        // 一定要打开channel的些事件，否则poller不会给channel通知epollout
+        channel_.enableWriting();
+    }
+}
+
+// 发送队列中的数据发出去一部分之后调用，检查低水位和内存预算
+void TcpConnection::outputDrained()
+{
+    size_t len = outputQueue_.readableBytes();
+    if (aboveHighWaterMark_ && len <= handlers_->lowWaterMark)
+    {
+        aboveHighWaterMark_ = false;
+        if (handlers_->lowWaterMarkCallBack)
+        {
+            loop_->queueInLoop(
+                std::bind(handlers_->lowWaterMarkCallBack, shared_from_this(), len));
+        }
+    }
+    // 连接可能已经被shutdown（如TcpServer::stop排空时），updateReading在kDisconnecting状态下
+    // 同样会恢复读取，对端的FIN才能被读到
+    if (outputPaused_ && outputQueue_.memoryBytes() <= handlers_->lowWaterMark)
+    {
+        outputPaused_ = false;
+        updateReading();
+    }
+}
+
+// 立即发送发送队列中的数据，没写完的部分注册EPOLLOUT交给handleWrite
+// auto cork模式下在本轮循环结束时调用，把攒下的数据一次写出
+void TcpConnection::flushOutput()
+{
+    flushPending_ = false;
+    if (state_ == kDisconnected || channel_.isWriting() ||
+        outputQueue_.empty())
+    {
+        return;
+    }
+
+    int saveErrno = 0;
+    ssize_t n = outputQueue_.writeFd(channel_.fd(), &saveErrno);
+    if (n > 0)
+    {
+        outputQueue_.retrieve(n);
+        outputDrained();
+    }
+    else if (n < 0 && saveErrno != EWOULDBLOCK)
+    {
+        // 对端已经断开，或者文件段无法继续发送，剩下的数据都没有意义了
+        LOG_ERROR("TcpConnection::flushOutput [%s] - errno %d, close connection \n",
+                  name().c_str(), saveErrno);
+        forceClose();
+        return;
+    }
+
+    if (outputQueue_.empty())
+    {
+        if (handlers_->writeCompleteCallBack)
+        {
+            loop_->queueInLoop(
+                std::bind(handlers_->writeCompleteCallBack, shared_from_this()));
+        }
+        if (state_ == kDisconnecting)
+        {
+            shutdownInLoop();
+        }
+    }
+    else
+    {
+        // 没写完的部分交给handleWrite
+        channel_.enableWriting();
+    }
+}
+
+void TcpConnection::setAutoCork(bool on)
+{
+    loop_->runInLoop(
+        [conn = shared_from_this(), on]()
+        {
+            conn->autoCork_ = on;
+            // 关闭时立即发出已经攒下的数据
+            if (!on && !conn->outputQueue_.empty() &&
+                !conn->channel_.isWriting())
+            {
+                conn->flushOutput();
+            }
+        });
+}
+
+void TcpConnection::startRead()
+{
+    loop_->runInLoop(
+        std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop()
+{
+    // 显式调用startRead时同时解除高水位的暂停
+    reading_ = true;
+    inputPaused_ = false;
+    updateReading();
+}
+
+// 应用希望读取、且没有因为高水位或内存预算暂停时才监听EPOLLIN
+// shutdown之后（kDisconnecting）仍要继续读，否则收不到对端的数据和FIN，连接无法走到handleClose
+void TcpConnection::updateReading()
+{
+    bool shouldRead = (state_ == kConnected || state_ == kDisconnecting) &&
+                      reading_ && !inputPaused_ && !outputPaused_ && !peerClosed_;
+    if (shouldRead && !channel_.isReading())
+    {
+        channel_.enableReading();
+    }
+    else if (!shouldRead && channel_.isReading())
+    {
+        channel_.disableReading();
+    }
+}
+
+void TcpConnection::stopRead()
+{
+    loop_->runInLoop(
+        std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopReadInLoop()
+{
+    reading_ = false;
+    updateReading();
+}
+
+void TcpConnection::setInputWaterMark(size_t highWaterMark,
+                                      size_t lowWaterMark)
+{
+    loop_->runInLoop(
+        [conn = shared_from_this(), highWaterMark, lowWaterMark]()
+        {
+            conn->inputHighWaterMark_ = highWaterMark;
+            conn->inputLowWaterMark_ = std::min(lowWaterMark, highWaterMark);
+        });
+}
+
+// 暂停读取期间每轮循环结束时检查一次，应用消费的数据足够多时恢复读取
+void TcpConnection::checkInputResume()
+{
+    if (!inputPaused_ || (state_ != kConnected && state_ != kDisconnecting))
+    {
+        return;
+    }
+    if (inputBuffer_.readableBytes() <= inputLowWaterMark_ ||
+        inputHighWaterMark_ == 0)
+    {
+        inputPaused_ = false;
+        updateReading();
+    }
+    else
+    {
+        // 在本轮循环结束时注册的回调会留到下一轮执行，不会空转
+        loop_->runAtIterationEnd(std::bind(&TcpConnection::checkInputResume,
+                                           shared_from_this()));
+    }
+}
+
+void TcpConnection::setZeroCopyThreshold(size_t threshold)
+{
+    loop_->runInLoop(
+        [conn = shared_from_this(), threshold]()
+        {
+            if (threshold > 0 && !conn->socket_.setZeroCopy(true))
+            {
+                LOG_ERROR("TcpConnection::setZeroCopyThreshold [%s] "
+                          "SO_ZEROCOPY not supported err:%d \n",
+                          conn->name().c_str(), errno);
+                return;
+            }
+            conn->outputQueue_.setZeroCopyThreshold(threshold);
+        });
+}
+
+void TcpConnection::setTcpCork(bool on)
+{
+    loop_->runInLoop([conn = shared_from_this(), on]()
+                     { conn->socket_.setTcpCork(on); });
 }
 
 // 建立连接
 void TcpConnection::connectEstablished()
 {
     setState(kConnected);
-    channel_->tie(shared_from_this());
-    channel_->enableReading(); // 注册channel的读事件
+    channel_.tie(shared_from_this());
+    channel_.enableReading(); // 注册channel的读事件
 
     // 新连接建立，执行回调
-    connectionCallBack_(shared_from_this());
+    handlers_->connectionCallBack(shared_from_this());
 }
 
 // 连接销毁
@@ -160,11 +710,11 @@ void TcpConnection::connectDestoryed()
     {
         setState(kDisconnected);
         // 把channel所有感兴趣的事件，从Poller中delete
-        channel_->disableAll();
-        connectionCallBack_(shared_from_this());
+        channel_.disableAll();
+        handlers_->connectionCallBack(shared_from_this());
     }
     // 把channel从poller中删除掉
-    channel_->remove();
+    channel_.remove();
 }
 
 // 关闭服务器的连接
@@ -179,22 +729,66 @@ void TcpConnection::shutdown()
 
 void TcpConnection::shutdownInLoop()
 {
-    // 说明当前outputBuff中的数据已经全部发送完全
-    if (!channel_->isWriting())
+    // 说明当前outputBuff中的数据已经全部发送完全（auto cork模式下还要等待flush，splice转发时还要等待管道清空）
+    if (!channel_.isWriting() && outputQueue_.empty() &&
+        (!splicePipe_ || splicePipe_->readableBytes() == 0))
+    {
+        socket_.shutdownWrite(); // 关闭写端
+        writeShutdown_ = true;
+        // splice转发时两个方向都已经结束，关闭连接
+        if (peerClosed_ && state_ != kDisconnected)
+        {
+            handleClose();
+        }
+    }
+}
+
+void TcpConnection::forceClose()
+{
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        setState(kDisconnecting);
+        // 放到队列中执行，避免在handleEvent的过程中关闭连接
+        loop_->queueInLoop(
+            std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop()
+{
+    if (state_ == kConnected || state_ == kDisconnecting)
     {
-        socket_->shutdownWrite(); // 关闭写端
+        handleClose();
     }
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
+    // splice转发模式下数据直接进入对端的管道
+    TcpConnectionPtr target = spliceTarget_.lock();
+    if (target)
+    {
+        handleSpliceRead(target);
+        return;
+    }
+
     int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+    ssize_t n = inputBuffer_.readFd(channel_.fd(), &savedErrno);
 
     // 有可读事件发生，调用回调
     if (n > 0)
     {
-        messageCallBack_(shared_from_this(), &inputBuffer_, receiveTime);
+        handlers_->messageCallBack(shared_from_this(), &inputBuffer_, receiveTime);
+        // 应用没有及时消费，暂停读取，直到inputBuffer_降到低水位以下
+        if (inputHighWaterMark_ > 0 && !inputPaused_ &&
+            inputBuffer_.readableBytes() >= inputHighWaterMark_ &&
+            channel_.isReading())
+        {
+            inputPaused_ = true;
+            updateReading();
+            loop_->runAtIterationEnd(std::bind(&TcpConnection::checkInputResume,
+                                               shared_from_this()));
+        }
     }
     // 断开
     else if (n == 0)
@@ -211,21 +805,34 @@ void TcpConnection::handleRead(Timestamp receiveTime)
 
 void TcpConnection::handleWrite()
 {
-    if (channel_->isWriting())
+    if (channel_.isWriting())
     {
+        // 发送队列中的数据先于管道中的数据发出
+        if (outputQueue_.empty() && splicePipe_)
+        {
+            writeSpliced();
+            return;
+        }
+
         int saveErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &saveErrno);
+        ssize_t n = outputQueue_.writeFd(channel_.fd(), &saveErrno);
 
-        if (n > 0)
+        if (n >= 0)
         {
-            outputBuffer_.retrieve(n);
-            if (outputBuffer_.readableBytes() == 0)
+            outputQueue_.retrieve(n);
+            outputDrained();
+            if (outputQueue_.empty() && splicePipe_ &&
+                splicePipe_->readableBytes() > 0)
+            {
+                writeSpliced();
+            }
+            else if (outputQueue_.empty())
             {
-                channel_->disableWriting();
-                if (writeCompleteCallBack_)
+                channel_.disableWriting();
+                if (handlers_->writeCompleteCallBack)
                 {
                     loop_->queueInLoop(
-                        std::bind(writeCompleteCallBack_, shared_from_this()));
+                        std::bind(handlers_->writeCompleteCallBack, shared_from_this()));
                 }
                 // 在发送过程中调用了shutdown，要等待数据发送完成，在shutdown
                 if (state_ == kDisconnecting)
@@ -234,38 +841,205 @@ void TcpConnection::handleWrite()
                 }
             }
         }
-        else
+        else if (saveErrno != EWOULDBLOCK)
         {
-            LOG_ERROR("TcpConnection::handleWrite");
+            // 出错后EPOLLOUT一直就绪，不关闭连接的话loop会不停地重试
+            LOG_ERROR("TcpConnection::handleWrite [%s] - errno %d, close connection \n",
+                      name().c_str(), saveErrno);
+            channel_.disableWriting();
+            forceClose();
         }
     }
     else
     {
         LOG_ERROR("TcpConnection fd=%d is down, no more writing \n",
-                  channel_->fd());
+                  channel_.fd());
+    }
+}
+
+void TcpConnection::startSplice(const TcpConnectionPtr &peer)
+{
+    loop_->runInLoop(std::bind(&TcpConnection::startSpliceInLoop,
+                               shared_from_this(), peer));
+}
+
+void TcpConnection::startSpliceInLoop(const TcpConnectionPtr &peer)
+{
+    if (peer->getloop() != loop_)
+    {
+        LOG_ERROR("TcpConnection::startSplice [%s] -> [%s] not in the same "
+                  "loop \n",
+                  name().c_str(), peer->name().c_str());
+        return;
+    }
+    if (!peer->splicePipe_)
+    {
+        std::unique_ptr<SplicePipe> pipe(new SplicePipe());
+        if (!pipe->valid())
+        {
+            return;
+        }
+        peer->splicePipe_ = std::move(pipe);
+    }
+
+    spliceTarget_ = peer;
+    peer->spliceSource_ = shared_from_this();
+    // 开始转发之前已经读到的数据走普通发送路径，保证顺序
+    if (inputBuffer_.readableBytes() > 0)
+    {
+        peer->send(&inputBuffer_);
+    }
+}
+
+// 本连接可读：socket => 对端的管道 => 对端socket
+void TcpConnection::handleSpliceRead(const TcpConnectionPtr &target)
+{
+    SplicePipe *pipe = target->splicePipe_.get();
+    if (pipe->full())
+    {
+        // 对端还没把管道中的数据发出去，暂停读取，等待对端writeSpliced恢复
+        channel_.disableReading();
+        return;
+    }
+
+    int savedErrno = 0;
+    ssize_t n = pipe->readFd(channel_.fd(), &savedErrno);
+    if (n > 0)
+    {
+        target->writeSpliced();
+        if (pipe->full())
+        {
+            channel_.disableReading();
+        }
+    }
+    // 对端关闭了写端，把半关闭传给target：等target把管道中剩下的数据发完后关闭它的写端
+    // 本连接停止读取，但target => 本连接方向的数据还要继续发送，两个方向都结束后才关闭
+    else if (n == 0)
+    {
+        target->shutdown();
+        peerClosed_ = true;
+        updateReading();
+        if (writeShutdown_)
+        {
+            handleClose();
+        }
+    }
+    else if (savedErrno != EAGAIN)
+    {
+        errno = savedErrno;
+        LOG_ERROR("TcpConnection::handleSpliceRead");
+        handleError();
+    }
+}
+
+// 把splicePipe_中的数据写到本连接的socket
+void TcpConnection::writeSpliced()
+{
+    if (state_ == kDisconnected)
+    {
+        return;
+    }
+    // 发送队列中还有数据，等handleWrite发完之后再写管道中的数据
+    if (!outputQueue_.empty())
+    {
+        if (!channel_.isWriting())
+        {
+            channel_.enableWriting();
+        }
+        return;
+    }
+
+    int savedErrno = 0;
+    ssize_t n = splicePipe_->writeFd(channel_.fd(), &savedErrno);
+    if (n < 0 && savedErrno != EAGAIN)
+    {
+        errno = savedErrno;
+        LOG_ERROR("TcpConnection::writeSpliced");
+        return;
+    }
+
+    if (splicePipe_->readableBytes() > 0)
+    {
+        if (!channel_.isWriting())
+        {
+            channel_.enableWriting();
+        }
+    }
+    else
+    {
+        if (channel_.isWriting())
+        {
+            channel_.disableWriting();
+        }
+        if (state_ == kDisconnecting)
+        {
+            shutdownInLoop();
+        }
+    }
+
+    // 管道有空间了，恢复读取源连接
+    TcpConnectionPtr source = spliceSource_.lock();
+    if (source && !splicePipe_->full())
+    {
+        source->updateReading();
     }
 }
 
 // 底层Poller通知channel在EPollHUP时，调用该方法
 void TcpConnection::handleClose()
 {
-    LOG_INFO("fd=%d state=%d \n", channel_->fd(), static_cast<int>(state_));
+    LOG_INFO("fd=%d state=%d \n", channel_.fd(), static_cast<int>(state_));
     setState(kDisconnected);
-    channel_->disableAll();
+    channel_.disableAll();
 
     TcpConnectionPtr connPtr(shared_from_this());
     // 执行连接关闭回调
-    connectionCallBack_(connPtr);
+    handlers_->connectionCallBack(connPtr);
     // 执行关闭连接回调 是TcpServer::removeConnection回调
-    closeCallBack_(connPtr);
+    handlers_->closeCallBack(connPtr);
+}
+
+// 零拷贝发送的完成通知通过socket的错误队列上报（触发EPOLLERR），
+// 读出所有通知并释放对应的数据，读到通知时返回true
+bool TcpConnection::handleZeroCopyCompletions()
+{
+    bool completed = false;
+    char control[128];
+    struct msghdr msg = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+    while (::recvmsg(channel_.fd(), &msg, MSG_ERRQUEUE) >= 0)
+    {
+        for (cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr;
+             cm = CMSG_NXTHDR(&msg, cm))
+        {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+                !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+            {
+                continue;
+            }
+            auto *serr = reinterpret_cast<sock_extended_err *>(CMSG_DATA(cm));
+            if (serr->ee_errno == 0 && serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+            {
+                // ee_info到ee_data是本次完成的发送编号范围
+                outputQueue_.zeroCopyCompleted(serr->ee_info, serr->ee_data);
+                completed = true;
+            }
+        }
+        msg.msg_controllen = sizeof control;
+    }
+    return completed;
 }
 
 void TcpConnection::handleError()
 {
+    bool zeroCopyCompleted =
+        outputQueue_.pinnedBytes() > 0 && handleZeroCopyCompletions();
+
     int optval;
     socklen_t optlen = sizeof(optval);
     int err = 0;
-    if (::getsockopt(channel_->fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen))
+    if (::getsockopt(channel_.fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen))
     {
         err = errno;
     }
@@ -273,8 +1047,15 @@ void TcpConnection::handleError()
     {
         err = optval;
     }
+    // 只是零拷贝的完成通知，不是真正的错误
+    if (zeroCopyCompleted && err == 0)
+    {
+        // 完成的数据已经从预算中扣除，可能可以恢复读取
+        outputDrained();
+        return;
+    }
     LOG_ERROR("TcpConnection::handleError name:%s - SO_ERROR:%d \n",
-              name_.c_str(), err);
+              name().c_str(), err);
 }
 
 } // namespace myMuduo
\ No newline at end of file
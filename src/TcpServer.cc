@@ -4,7 +4,9 @@
 #include "TcpConnection.h"
 
 #include <functional>
+#include <memory>
 #include <string.h>
+#include <unistd.h>
 
 namespace myMuduo
 {
@@ -18,16 +20,49 @@ static EventLoop *checkLoopNotNull(EventLoop *loop)
     return loop;
 }
 
+// 监听fd绑定的本地地址
+static std::string localIpPort(int sockfd)
+{
+    sockaddr_storage local;
+    memset(&local, 0, sizeof(local));
+    socklen_t addrlen = sizeof(local);
+    if (::getsockname(sockfd, (sockaddr *)&local, &addrlen))
+    {
+        LOG_ERROR("sockets::getLocalAddr");
+    }
+    return InetAddress((sockaddr *)&local, addrlen).toIpPort();
+}
+
 TcpServer::TcpServer(EventLoop *loop,
                      const InetAddress &listenAddr,
                      const std::string &name,
                      Option option)
-    : loop_(checkLoopNotNull(loop)), ipPort_(listenAddr.toIpPort()),
-      name_(name),
-      acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)),
-      threadPool_(new EventLoopThreadPool(loop_, name_)), connectionCallBack_(),
-      messageCallBack_(), nextConnId_(1), started_(0)
+    : TcpServer(loop,
+                new Acceptor(loop, listenAddr, option == kReusePort),
+                listenAddr.toIpPort(),
+                name)
 {
+}
+
+TcpServer::TcpServer(EventLoop *loop, int listenFd, const std::string &name)
+    : TcpServer(loop, new Acceptor(loop, listenFd), localIpPort(listenFd), name)
+{
+}
+
+TcpServer::TcpServer(EventLoop *loop,
+                     Acceptor *acceptor,
+                     const std::string &ipPort,
+                     const std::string &name)
+    : loop_(checkLoopNotNull(loop)), ipPort_(ipPort), name_(name),
+      acceptor_(acceptor), threadPool_(new EventLoopThreadPool(loop_, name_)),
+      handlers_(std::make_shared<ConnectionHandlers>()), nextConnId_(1),
+      started_(0)
+{
+    handlers_->name = name_ + "-" + ipPort_;
+    // 关闭连接的回调，不是由用户设置的
+    handlers_->closeCallBack = [this](const TcpConnectionPtr &conn)
+    { removeConnection(conn); };
+
     // 当有新用户连接时，会执行TcpServer::newConnection回调
     acceptor_->setNewConnectionCallBack(std::bind(&TcpServer::newConnection,
                                                   this, std::placeholders::_1,
@@ -36,13 +71,32 @@ TcpServer::TcpServer(EventLoop *loop,
 
 TcpServer::~TcpServer()
 {
-    for (auto &item : connections_)
+    for (std::shared_ptr<ConnectionShard> &shard : shards_)
+    {
+        ConnectionMap connections;
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            connections.swap(shard->connections);
+            shard->closed = true; // 还没有执行的构造任务不再登记连接
+        }
+        for (auto &item : connections)
+        {
+            TcpConnectionPtr conn(item.second); // 局部对象，出了作用域自动被析构
+            item.second.reset(); // 释放Tcpserver中的TcpConnection指针
+            conn->getloop()->runInLoop(
+                std::bind(&TcpConnection::connectDestoryed, conn));
+        }
+    }
+}
+
+ConnectionHandlers &TcpServer::mutableHandlers()
+{
+    // 已经建立的连接还在使用旧表，拷贝一份再修改
+    if (handlers_.use_count() > 1)
     {
-        TcpConnectionPtr conn(item.second); // 局部对象，出了作用域自动被析构
-        item.second.reset(); // 释放Tcpserver中的TcpConnection指针
-        conn->getloop()->runInLoop(
-            std::bind(&TcpConnection::connectDestoryed, conn));
+        handlers_ = std::make_shared<ConnectionHandlers>(*handlers_);
     }
+    return *handlers_;
 }
 
 // 设置subloop个数
@@ -59,65 +113,227 @@ void TcpServer::start()
     {
         // 启动底层线程池
         threadPool_->start(threadInitCallBack_);
+        loops_ = threadPool_->getAllLoops();
+        for (size_t i = 0; i < loops_.size(); ++i)
+        {
+            shards_.push_back(std::make_shared<ConnectionShard>());
+        }
         loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
     }
 }
 
-// 有一个新的客户端的连接，会执行该回调操作
-void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
+void TcpServer::enableHandoff(const std::string &path,
+                              const ListenSocketHandoff::HandoffCallBack &cb)
 {
-    // 轮询算法，选择一个subloop来管理该新连接的channel
-    EventLoop *ioLoop = threadPool_->getNextLoop();
-    char buf[64] = {0};
-    snprintf(buf, sizeof(buf), "-%s#%d", ipPort_.c_str(), nextConnId_);
-    ++nextConnId_;
-    std::string connName = name_ + buf;
+    loop_->runInLoop(
+        [this, path, cb]()
+        {
+            handoff_.reset(new ListenSocketHandoff(loop_, path, acceptor_->fd()));
+            handoff_->setHandoffCallBack(
+                [this, cb]()
+                {
+                    // 新进程已经拿到监听fd，之后的stop不能再shutdown监听socket
+                    acceptor_->setShared();
+                    if (cb)
+                    {
+                        cb();
+                    }
+                });
+            handoff_->start();
+        });
+}
 
-    LOG_INFO("TcpServe::newConnection [%s] - new connection [%s] from %s \n",
-             name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
+void TcpServer::stop(double drainTimeout, DrainCallBack cb)
+{
+    loop_->runInLoop([this, drainTimeout, cb = std::move(cb)]()
+                     { stopInLoop(drainTimeout, cb); });
+}
 
-    // 通过sockfd绑定的服务器的ip地址和端口信息
-    sockaddr_in local;
-    memset(&local, 0, sizeof(local));
-    socklen_t addrlen = sizeof(local);
+void TcpServer::stopInLoop(double drainTimeout, const DrainCallBack &cb)
+{
+    acceptor_->stop();
 
-    if (::getsockname(sockfd, (sockaddr *)&local, &addrlen))
+    std::vector<TcpConnectionPtr> conns = allConnections();
+    LOG_INFO("TcpServer::stop [%s] - draining %lu connections, timeout %.1fs \n",
+             name_.c_str(), conns.size(), drainTimeout);
+    // shutdown会等发送队列中的数据全部发出后才关闭写端
+    for (const TcpConnectionPtr &conn : conns)
     {
-        LOG_ERROR("sockets::getLocalAddr");
+        conn->shutdown();
     }
 
-    InetAddress localAddr(local);
+    Timestamp deadline = addTime(Timestamp::monotonicNow(), drainTimeout);
+    checkDrain(deadline, cb, false);
+}
 
-    // 根据连接成功的sockfd,创建tcpConnection连接对象
-    TcpConnectionPtr conn(
-        new TcpConnection(ioLoop, connName, sockfd, localAddr, peerAddr));
+void TcpServer::checkDrain(Timestamp deadline,
+                           const DrainCallBack &cb,
+                           bool forced)
+{
+    size_t remaining = connectionCount();
+    if (cb)
+    {
+        cb(remaining);
+    }
+    if (remaining == 0)
+    {
+        LOG_INFO("TcpServer::stop [%s] - all connections closed \n",
+                 name_.c_str());
+        return;
+    }
 
-    connections_[connName] = conn;
-    // 下面的回调都是用户设置给Tcpserver=》Tcpconnection=》Channel=》
-    // Poller=》notify channel回调
-    conn->setConnectionCallBack(connectionCallBack_);
-    conn->setMessageCallBack(messageCallBack_);
-    conn->setWriteCompleteCallBack(writeCompleteCallBack_);
-    // 关闭连接的回调，不是由用户设置的
-    conn->setCloseCallBack(
-        std::bind(&TcpServer::removeConnection, this, std::placeholders::_1));
-    // 直接调用
-    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    // 超时后还没有关闭的连接（对端一直不关闭或者发送不完）强制关闭，
+    // 超时时刚建立完成的连接也会在之后的检查中被关闭
+    if (Timestamp::monotonicNow() >= deadline)
+    {
+        if (!forced)
+        {
+            LOG_ERROR("TcpServer::stop [%s] - drain timeout, force close %lu "
+                      "connections \n",
+                      name_.c_str(), remaining);
+            forced = true;
+        }
+        for (const TcpConnectionPtr &conn : allConnections())
+        {
+            conn->forceClose();
+        }
+    }
+    loop_->runAfter(kDrainCheckInterval, [this, deadline, cb, forced]()
+                    { checkDrain(deadline, cb, forced); });
 }
 
-void TcpServer::removeConnection(const TcpConnectionPtr &conn)
+std::vector<TcpConnectionPtr> TcpServer::allConnections() const
 {
-    loop_->runInLoop(std::bind(&TcpServer::removeConnectionInLoop, this, conn));
+    std::vector<TcpConnectionPtr> conns;
+    for (const std::shared_ptr<ConnectionShard> &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto &item : shard->connections)
+        {
+            conns.push_back(item.second);
+        }
+    }
+    return conns;
 }
 
-void TcpServer::removeConnectionInLoop(const TcpConnectionPtr &conn)
+TcpConnectionPtr TcpServer::getConnection(uint64_t id) const
 {
-    LOG_INFO("TcpServer::removeConnectionInLoop [%s] - connection %s \n",
+    if (shards_.empty())
+    {
+        return TcpConnectionPtr();
+    }
+    ConnectionShard &shard = shardOf(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.connections.find(id);
+    return it != shard.connections.end() ? it->second : TcpConnectionPtr();
+}
+
+size_t TcpServer::connectionCount() const
+{
+    size_t count = 0;
+    for (const std::shared_ptr<ConnectionShard> &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->connections.size();
+    }
+    return count;
+}
+
+void TcpServer::broadcast(const std::vector<TcpConnectionPtr> &conns,
+                          const SharedBuffer &buf)
+{
+    std::unordered_map<EventLoop *, std::vector<TcpConnectionPtr>> groups;
+    for (const TcpConnectionPtr &conn : conns)
+    {
+        groups[conn->getloop()].push_back(conn);
+    }
+
+    for (auto &[loop, group] : groups)
+    {
+        // 在subloop中执行时send直接走sendInLoop，不会再次投递任务
+        loop->runInLoop(
+            [group = std::move(group), buf]()
+            {
+                for (const TcpConnectionPtr &conn : group)
+                {
+                    conn->send(buf);
+                }
+            });
+    }
+}
+
+// 有一个新的客户端的连接，会执行该回调操作
+void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
+{
+    // 发送队列占用的内存已经超过预算，拒绝新连接
+    // 每个连接都要打日志，地址格式化到栈上，不分配string
+    char peer[InetAddress::kMaxStringLength];
+    peerAddr.formatTo(peer, sizeof peer);
+
+    if (OutputBudget::exceeded())
+    {
+        LOG_ERROR("TcpServer::newConnection [%s] - refuse %s, output memory "
+                  "%lu over budget %lu \n",
+                  name_.c_str(), peer, OutputBudget::used(),
+                  OutputBudget::limit());
+        ::close(sockfd);
+        return;
+    }
+
+    // id是递增的，按id取模选择subloop就是轮询，同时查找时可以直接算出所属的分片
+    uint64_t id = nextConnId_++;
+    EventLoop *ioLoop = loops_[id % loops_.size()];
+
+    LOG_INFO("TcpServe::newConnection [%s] - new connection [%s#%lu] from %s \n",
+             name_.c_str(), handlers_->name.c_str(), id, peer);
+
+    // 根据连接成功的sockfd,在ioLoop中创建tcpConnection连接对象
+    ioLoop->runInLoop(
+        [ioLoop, shard = shards_[id % shards_.size()], handlers = handlers_, id,
+         sockfd, peerAddr]()
+        { newConnectionInLoop(ioLoop, shard, handlers, id, sockfd, peerAddr); });
+}
+
+void TcpServer::newConnectionInLoop(
+    EventLoop *ioLoop,
+    const std::shared_ptr<ConnectionShard> &shard,
+    const std::shared_ptr<ConnectionHandlers> &handlers,
+    uint64_t id,
+    int sockfd,
+    const InetAddress &peerAddr)
+{
+    // 连接对象和shared_ptr的控制块一起从ioLoop的对象池分配，断开后内存留给下一个连接
+    TcpConnectionPtr conn = std::allocate_shared<TcpConnection>(
+        PoolAllocator<TcpConnection>(ioLoop->connectionPool()), ioLoop, id,
+        sockfd, peerAddr);
+
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        if (shard->closed)
+        {
+            return; // TcpServer已经析构，conn析构时关闭sockfd
+        }
+        shard->connections[id] = conn;
+    }
+    // 用户设置给Tcpserver的回调表=》Tcpconnection=》Channel=》
+    // Poller=》notify channel回调，连接只持有回调表的引用
+    conn->setHandlers(handlers);
+    conn->connectEstablished();
+}
+
+// 在连接所属的subloop中执行，直接从该subloop的分片中删除
+void TcpServer::removeConnection(const TcpConnectionPtr &conn)
+{
+    LOG_INFO("TcpServer::removeConnection [%s] - connection %s \n",
              name_.c_str(), conn->name().c_str());
 
-    connections_.erase(conn->name());
-    EventLoop *ioLoop = conn->getloop();
-    ioLoop->queueInLoop(std::bind(&TcpConnection::connectDestoryed, conn));
+    {
+        ConnectionShard &shard = shardOf(conn->id());
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.connections.erase(conn->id());
+    }
+    conn->getloop()->queueInLoop(
+        std::bind(&TcpConnection::connectDestoryed, conn));
 }
 
 } // namespace myMuduo
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Thread.h"
 #include "CurrentThread.h"
 
+#include <pthread.h>
 #include <semaphore>
 
 namespace myMuduo
@@ -37,6 +38,9 @@ void Thread::start()
         {
             // 获取线程tid
             tid_ = CurrentThread::tid();
+            // 设置线程名，top -H、perf、gdb中可以看到，内核限制最多15个字符
+            ::pthread_setname_np(::pthread_self(),
+                                 name_.substr(0, 15).c_str());
             // sem_post(&sem);
             sem.release();
             func_(); // 开启一个新线程，专门执行该线程函数
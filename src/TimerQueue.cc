@@ -0,0 +1,95 @@
+#include "TimerQueue.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <vector>
+
+namespace myMuduo
+{
+static int createTimerfd()
+{
+    int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0)
+    {
+        LOG_FATAL("timerfd_create error:%d \n", errno);
+    }
+    return timerfd;
+}
+
+TimerQueue::TimerQueue(EventLoop *loop)
+    : loop_(loop), timerfd_(createTimerfd()), timerChannel_(loop, timerfd_)
+{
+    timerChannel_.setReadCallBack([this](Timestamp) { handleRead(); });
+    timerChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue()
+{
+    timerChannel_.disableAll();
+    timerChannel_.remove();
+    ::close(timerfd_);
+}
+
+void TimerQueue::addTimer(Clock::time_point when, Functor cb)
+{
+    bool earliest = timers_.empty() || when < timers_.begin()->first;
+    timers_.emplace(when, std::move(cb));
+    if (earliest)
+    {
+        resetTimerfd();
+    }
+}
+
+void TimerQueue::handleRead()
+{
+    uint64_t howmany;
+    ssize_t n = ::read(timerfd_, &howmany, sizeof howmany);
+    if (n != sizeof howmany)
+    {
+        LOG_ERROR("TimerQueue::handleRead() reads %ld bytes instead of 8 \n", n);
+    }
+
+    // 先取出所有到期的定时器再执行，回调中可能会添加新的定时器
+    std::vector<Functor> expired;
+    Clock::time_point now = Clock::now();
+    auto end = timers_.upper_bound(now);
+    for (auto it = timers_.begin(); it != end; ++it)
+    {
+        expired.push_back(std::move(it->second));
+    }
+    timers_.erase(timers_.begin(), end);
+
+    for (const Functor &cb : expired)
+    {
+        cb();
+    }
+
+    if (!timers_.empty())
+    {
+        resetTimerfd();
+    }
+}
+
+void TimerQueue::resetTimerfd()
+{
+    auto delay = std::chrono::duration_cast<std::chrono::microseconds>(
+        timers_.begin()->first - Clock::now());
+    // 已经到期的定时器也要让timerfd触发一次，最少等待100微秒
+    if (delay.count() < 100)
+    {
+        delay = std::chrono::microseconds(100);
+    }
+
+    struct itimerspec newValue;
+    memset(&newValue, 0, sizeof newValue);
+    newValue.it_value.tv_sec = delay.count() / 1000000;
+    newValue.it_value.tv_nsec = (delay.count() % 1000000) * 1000;
+    if (::timerfd_settime(timerfd_, 0, &newValue, nullptr) < 0)
+    {
+        LOG_ERROR("timerfd_settime error:%d \n", errno);
+    }
+}
+} // namespace myMuduo
@@ -1,9 +1,21 @@
 #include "Timestamp.h"
 
-#include <time.h>
+#include <stdio.h>
+#include <string.h>
 
 namespace myMuduo
 {
+namespace
+{
+int64_t clockMicroSeconds(clockid_t clock)
+{
+    struct timespec ts;
+    ::clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * Timestamp::kMicroSecondsPerSecond +
+           ts.tv_nsec / 1000;
+}
+} // namespace
+
 Timestamp::Timestamp() : microSecondsSinceEpoch_(0) {}
 
 Timestamp::Timestamp(int64_t microSecondsSinceEpoch)
@@ -12,26 +24,74 @@ Timestamp::Timestamp(int64_t microSecondsSinceEpoch)
 }
 
 // 获取当前时间
-Timestamp Timestamp::now() { return Timestamp(time(nullptr)); }
+Timestamp Timestamp::now()
+{
+    return Timestamp(clockMicroSeconds(CLOCK_REALTIME));
+}
+
+Timestamp Timestamp::monotonicNow()
+{
+    return Timestamp(clockMicroSeconds(CLOCK_MONOTONIC));
+}
 
 // 时间转为string
 std::string Timestamp::toString() const
 {
-    char buf[128] = {0};
-    tm *tmTime = localtime(&microSecondsSinceEpoch_);
-    snprintf(buf, 128, "%4d/%02d/%02d %02d:%02d:%02d", tmTime->tm_year + 1900,
-             tmTime->tm_mon + 1, tmTime->tm_mday, tmTime->tm_hour,
-             tmTime->tm_min, tmTime->tm_sec);
+    char buf[64];
+    size_t len = formatTo(buf, sizeof buf, false);
+    return std::string(buf, len);
+}
 
-    return buf;
+std::string Timestamp::toFormattedString(bool showMicroseconds) const
+{
+    char buf[64];
+    size_t len = formatTo(buf, sizeof buf, showMicroseconds);
+    return std::string(buf, len);
 }
-} // namespace myMuduo
 
-// #include <iostream>
+size_t Timestamp::formatTo(char *buf, size_t size, bool showMicroseconds) const
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    // 每个线程缓存最近一秒的 年/月/日 时:分:秒
+    thread_local time_t t_lastSecond = -1;
+    thread_local char t_date[64];
+    thread_local size_t t_dateLen = 0;
+
+    time_t seconds = secondsSinceEpoch();
+    if (seconds != t_lastSecond)
+    {
+        struct tm tm;
+        ::localtime_r(&seconds, &tm);
+        int n = snprintf(t_date, sizeof t_date, "%4d/%02d/%02d %02d:%02d:%02d",
+                         tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                         tm.tm_hour, tm.tm_min, tm.tm_sec);
+        t_dateLen = n > 0 ? static_cast<size_t>(n) : 0;
+        t_lastSecond = seconds;
+    }
 
-// int main()
-// {
-//     std::cout << myMuduo::Timestamp::now().toString() << std::endl;
+    char tmp[80];
+    ::memcpy(tmp, t_date, t_dateLen);
+    size_t len = t_dateLen;
+    if (showMicroseconds)
+    {
+        int micros =
+            static_cast<int>(microSecondsSinceEpoch_ % kMicroSecondsPerSecond);
+        tmp[len] = '.';
+        for (int i = 6; i > 0; --i)
+        {
+            tmp[len + i] = static_cast<char>('0' + micros % 10);
+            micros /= 10;
+        }
+        len += 7;
+    }
 
-//     return 0;
-// }
\ No newline at end of file
+    len = len < size ? len : size - 1;
+    ::memcpy(buf, tmp, len);
+    buf[len] = '\0';
+    return len;
+}
+} // namespace myMuduo
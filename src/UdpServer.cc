@@ -0,0 +1,107 @@
+#include "UdpServer.h"
+#include "Logger.h"
+
+#include <future>
+
+namespace myMuduo
+{
+UdpServer::UdpServer(EventLoop *loop,
+                     const InetAddress &listenAddr,
+                     const std::string &name)
+    : loop_(loop), listenAddr_(listenAddr), name_(name),
+      threadPool_(new EventLoopThreadPool(loop, name)),
+      batchSize_(UdpSocket::kDefaultBatchSize),
+      datagramSize_(UdpSocket::kDefaultDatagramSize), gro_(false),
+      gso_(false), started_(0)
+{
+}
+
+UdpServer::~UdpServer()
+{
+    for (std::shared_ptr<UdpSocket> &socket : sockets_)
+    {
+        EventLoop *ioLoop = socket->getLoop();
+        if (ioLoop->isInLoopThread())
+        {
+            socket.reset();
+        }
+        else
+        {
+            // channel只能在所属loop中移除，等它析构完再继续，之后线程池才会退出subloop
+            std::promise<void> destroyed;
+            ioLoop->runInLoop(
+                [&socket, &destroyed]()
+                {
+                    socket.reset();
+                    destroyed.set_value();
+                });
+            destroyed.get_future().wait();
+        }
+    }
+}
+
+void UdpServer::setThreadNum(int numThreads)
+{
+    threadPool_->setThread(numThreads);
+}
+
+void UdpServer::start()
+{
+    if (started_++ != 0)
+    {
+        return;
+    }
+
+    threadPool_->start(threadInitCallBack_);
+    std::vector<EventLoop *> loops = threadPool_->getAllLoops();
+    for (EventLoop *ioLoop : loops)
+    {
+        // 在当前线程中创建和bind，端口被占用时在这里就能发现
+        std::shared_ptr<UdpSocket> socket = std::make_shared<UdpSocket>(
+            ioLoop, listenAddr_, loops.size() > 1, batchSize_, datagramSize_);
+        socket->setMessageCallBack(messageCallBack_);
+        if (gro_)
+        {
+            socket->enableGro();
+        }
+        if (gso_)
+        {
+            socket->enableGso();
+        }
+        sockets_.push_back(socket);
+        ioLoop->runInLoop([socket]() { socket->start(); });
+    }
+    LOG_INFO("UdpServer [%s] - listening on %s with %lu sockets \n",
+             name_.c_str(), listenAddr_.toIpPort().c_str(), sockets_.size());
+}
+
+uint64_t UdpServer::receivedDatagrams() const
+{
+    uint64_t n = 0;
+    for (const std::shared_ptr<UdpSocket> &socket : sockets_)
+    {
+        n += socket->receivedDatagrams();
+    }
+    return n;
+}
+
+uint64_t UdpServer::sentDatagrams() const
+{
+    uint64_t n = 0;
+    for (const std::shared_ptr<UdpSocket> &socket : sockets_)
+    {
+        n += socket->sentDatagrams();
+    }
+    return n;
+}
+
+uint64_t UdpServer::droppedDatagrams() const
+{
+    uint64_t n = 0;
+    for (const std::shared_ptr<UdpSocket> &socket : sockets_)
+    {
+        n += socket->droppedDatagrams();
+    }
+    return n;
+}
+} // namespace myMuduo
@@ -0,0 +1,369 @@
+#include "UdpSocket.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace myMuduo
+{
+// 一次可读事件中最多调用recvmmsg的次数，避免一个socket占住loop
+static constexpr int kMaxReadRounds = 8;
+// 开启GRO后一个接收缓冲区要能放下合并后的最大数据报
+static constexpr size_t kGroDatagramSize = 65536;
+// 一次UDP_SEGMENT发送的上限：内核最多分成64段，总长度不超过一个IP包
+static constexpr size_t kMaxGsoSegments = 64;
+static constexpr size_t kMaxGsoBytes = 65507;
+
+static int createNonblocking(sa_family_t family)
+{
+    int sockfd =
+        ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (sockfd < 0)
+    {
+        LOG_FATAL("%s:%s:%d udp socket create err:%d \n", __FILE__, __func__,
+                  __LINE__, errno);
+    }
+    return sockfd;
+}
+
+UdpSocket::UdpSocket(EventLoop *loop,
+                     const InetAddress &bindAddr,
+                     bool reuseport,
+                     int batchSize,
+                     size_t datagramSize)
+    : loop_(loop), socket_(createNonblocking(bindAddr.family())), channel_(loop, socket_.fd()),
+      batchSize_(std::max(batchSize, 1)), datagramSize_(datagramSize),
+      gro_(false), gso_(false), handlingRead_(false), flushQueued_(false),
+      received_(0), sent_(0), dropped_(0)
+{
+    socket_.setReuseAddr(true);
+    socket_.setReusePort(reuseport);
+    socket_.bindAddress(bindAddr);
+    setupRecvBuffers();
+
+    sendMsgs_.resize(batchSize_);
+    sendIovecs_.resize(batchSize_);
+    sendControl_.resize(batchSize_ * CMSG_SPACE(sizeof(uint16_t)));
+
+    channel_.setReadCallBack(
+        [this](Timestamp receiveTime) { handleRead(receiveTime); });
+}
+
+UdpSocket::~UdpSocket()
+{
+    flush();
+    channel_.disableAll();
+    channel_.remove();
+}
+
+void UdpSocket::setupRecvBuffers()
+{
+    size_t size = gro_ ? kGroDatagramSize : datagramSize_;
+    size_t controlSize = CMSG_SPACE(sizeof(int));
+    recvBuf_.assign(batchSize_ * size, 0);
+    recvMsgs_.assign(batchSize_, mmsghdr());
+    recvIovecs_.resize(batchSize_);
+    recvAddrs_.resize(batchSize_);
+    recvControl_.assign(gro_ ? batchSize_ * controlSize : 0, 0);
+
+    for (int i = 0; i < batchSize_; ++i)
+    {
+        recvIovecs_[i].iov_base = &recvBuf_[i * size];
+        recvIovecs_[i].iov_len = size;
+        msghdr &hdr = recvMsgs_[i].msg_hdr;
+        hdr.msg_name = &recvAddrs_[i];
+        hdr.msg_namelen = sizeof(sockaddr_storage);
+        hdr.msg_iov = &recvIovecs_[i];
+        hdr.msg_iovlen = 1;
+        if (gro_)
+        {
+            hdr.msg_control = &recvControl_[i * controlSize];
+            hdr.msg_controllen = controlSize;
+        }
+    }
+}
+
+bool UdpSocket::enableGro()
+{
+    int on = 1;
+    if (::setsockopt(socket_.fd(), SOL_UDP, UDP_GRO, &on, sizeof(on)) < 0)
+    {
+        LOG_ERROR("UdpSocket::enableGro - UDP_GRO not supported err:%d \n",
+                  errno);
+        return false;
+    }
+    gro_ = true;
+    setupRecvBuffers();
+    return true;
+}
+
+bool UdpSocket::enableGso()
+{
+    // 把socket级别的分段大小设为0不改变行为，只用来探测内核是否支持
+    int size = 0;
+    if (::setsockopt(socket_.fd(), SOL_UDP, UDP_SEGMENT, &size, sizeof(size)) <
+        0)
+    {
+        LOG_ERROR("UdpSocket::enableGso - UDP_SEGMENT not supported err:%d \n",
+                  errno);
+        return false;
+    }
+    gso_ = true;
+    return true;
+}
+
+void UdpSocket::start() { channel_.enableReading(); }
+
+void UdpSocket::stop() { channel_.disableAll(); }
+
+InetAddress UdpSocket::localAddress() const
+{
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    if (::getsockname(socket_.fd(), (sockaddr *)&addr, &len) < 0)
+    {
+        LOG_ERROR("UdpSocket::localAddress - getsockname err:%d \n", errno);
+    }
+    return InetAddress((sockaddr *)&addr, len);
+}
+
+void UdpSocket::handleRead(Timestamp receiveTime)
+{
+    handlingRead_ = true;
+    size_t size = gro_ ? kGroDatagramSize : datagramSize_;
+    uint64_t received = 0;
+    uint64_t dropped = 0;
+    for (int round = 0; round < kMaxReadRounds; ++round)
+    {
+        int n = ::recvmmsg(socket_.fd(), recvMsgs_.data(), batchSize_,
+                           MSG_DONTWAIT, nullptr);
+        if (n < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                LOG_ERROR("UdpSocket::handleRead - recvmmsg err:%d \n", errno);
+            }
+            break;
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            msghdr &hdr = recvMsgs_[i].msg_hdr;
+            size_t len = recvMsgs_[i].msg_len;
+            if (hdr.msg_flags & MSG_TRUNC)
+            {
+                ++dropped;
+            }
+            else
+            {
+                // GRO合并的数据报由控制消息给出原来每段的大小
+                size_t segment = len;
+                for (cmsghdr *cmsg = gro_ ? CMSG_FIRSTHDR(&hdr) : nullptr;
+                     cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg))
+                {
+                    if (cmsg->cmsg_level == SOL_UDP &&
+                        cmsg->cmsg_type == UDP_GRO)
+                    {
+                        int gsoSize = 0;
+                        memcpy(&gsoSize, CMSG_DATA(cmsg), sizeof(gsoSize));
+                        if (gsoSize > 0)
+                        {
+                            segment = gsoSize;
+                        }
+                    }
+                }
+
+                InetAddress peer(reinterpret_cast<const sockaddr *>(&recvAddrs_[i]),
+                                 hdr.msg_namelen);
+                const char *data =
+                    static_cast<const char *>(hdr.msg_iov->iov_base);
+                size_t offset = 0;
+                // 空数据报也要回调一次
+                do
+                {
+                    size_t segmentLen = std::min(segment, len - offset);
+                    ++received;
+                    if (messageCallBack_)
+                    {
+                        messageCallBack_(this, data + offset, segmentLen, peer,
+                                         receiveTime);
+                    }
+                    offset += segmentLen;
+                } while (offset < len);
+            }
+            // 内核会改写这几个字段，下一次recvmmsg之前恢复
+            hdr.msg_namelen = sizeof(sockaddr_storage);
+            hdr.msg_flags = 0;
+            if (gro_)
+            {
+                hdr.msg_controllen = CMSG_SPACE(sizeof(int));
+            }
+            recvIovecs_[i].iov_len = size;
+        }
+
+        if (n < batchSize_)
+        {
+            break;
+        }
+    }
+    handlingRead_ = false;
+    // 单写者，统计值可以在其他线程中读取
+    received_.fetch_add(received, std::memory_order_relaxed);
+    dropped_.fetch_add(dropped, std::memory_order_relaxed);
+    flush();
+}
+
+void UdpSocket::sendTo(const char *data, size_t len, const InetAddress &peer)
+{
+    append(data, len, peer, 0);
+}
+
+void UdpSocket::sendSegments(const char *data,
+                             size_t len,
+                             size_t segmentSize,
+                             const InetAddress &peer)
+{
+    if (segmentSize == 0 || segmentSize > UINT16_MAX)
+    {
+        return;
+    }
+    if (!gso_)
+    {
+        for (size_t offset = 0; offset < len; offset += segmentSize)
+        {
+            append(data + offset, std::min(segmentSize, len - offset), peer, 0);
+        }
+        return;
+    }
+
+    size_t chunk = std::min(kMaxGsoSegments, kMaxGsoBytes / segmentSize) *
+                   segmentSize;
+    for (size_t offset = 0; offset < len; offset += chunk)
+    {
+        size_t n = std::min(chunk, len - offset);
+        // 只有一段时不需要分段
+        append(data + offset, n, peer,
+               n > segmentSize ? static_cast<uint16_t>(segmentSize) : 0);
+    }
+}
+
+void UdpSocket::append(const char *data,
+                       size_t len,
+                       const InetAddress &peer,
+                       uint16_t segmentSize)
+{
+    loop_->assertInLoopThread();
+    size_t offset = sendBuf_.size();
+    sendBuf_.insert(sendBuf_.end(), data, data + len);
+    pending_.push_back({offset, len, peer, segmentSize});
+
+    if (static_cast<int>(pending_.size()) >= batchSize_)
+    {
+        flush();
+    }
+    else if (!handlingRead_ && !flushQueued_)
+    {
+        // 在回调之外调用时，本轮事件处理完后一起发送
+        flushQueued_ = true;
+        std::weak_ptr<UdpSocket> weakSelf(weak_from_this());
+        if (weakSelf.expired())
+        {
+            // 没有用shared_ptr管理时无法保证任务执行时对象还在，直接发送
+            flushQueued_ = false;
+            flush();
+            return;
+        }
+        loop_->queueInLoop(
+            [weakSelf]()
+            {
+                std::shared_ptr<UdpSocket> self = weakSelf.lock();
+                if (self)
+                {
+                    self->flushQueued_ = false;
+                    self->flush();
+                }
+            });
+    }
+}
+
+void UdpSocket::flush()
+{
+    if (pending_.empty())
+    {
+        return;
+    }
+
+    size_t controlSize = CMSG_SPACE(sizeof(uint16_t));
+    int n = static_cast<int>(pending_.size());
+    for (int i = 0; i < n; ++i)
+    {
+        PendingDatagram &d = pending_[i];
+        sendIovecs_[i].iov_base = &sendBuf_[d.offset];
+        sendIovecs_[i].iov_len = d.len;
+        msghdr &hdr = sendMsgs_[i].msg_hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = const_cast<sockaddr *>(d.peer.getSockAddr());
+        hdr.msg_namelen = d.peer.getSockLen();
+        hdr.msg_iov = &sendIovecs_[i];
+        hdr.msg_iovlen = 1;
+        if (d.segmentSize != 0)
+        {
+            hdr.msg_control = &sendControl_[i * controlSize];
+            hdr.msg_controllen = controlSize;
+            cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            memcpy(CMSG_DATA(cmsg), &d.segmentSize, sizeof(uint16_t));
+        }
+    }
+
+    // 一个条目开启分段时对应多个数据报
+    auto datagramsOf = [](const PendingDatagram &d) -> uint64_t
+    {
+        return d.segmentSize == 0
+                   ? 1
+                   : (d.len + d.segmentSize - 1) / d.segmentSize;
+    };
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+    int done = 0;
+    while (done < n)
+    {
+        int ret = ::sendmmsg(socket_.fd(), &sendMsgs_[done], n - done, 0);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // 发送缓冲区满（EAGAIN）或者目的地不可达，UDP不重发，丢弃出错的数据报后继续
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                LOG_ERROR("UdpSocket::flush - sendmmsg to %s err:%d \n",
+                          pending_[done].peer.toIpPort().c_str(),
+                          errno);
+            }
+            dropped += datagramsOf(pending_[done]);
+            ++done;
+            continue;
+        }
+        for (int i = done; i < done + ret; ++i)
+        {
+            sent += datagramsOf(pending_[i]);
+        }
+        done += ret;
+    }
+
+    sent_.fetch_add(sent, std::memory_order_relaxed);
+    dropped_.fetch_add(dropped, std::memory_order_relaxed);
+    pending_.clear();
+    sendBuf_.clear();
+}
+} // namespace myMuduo
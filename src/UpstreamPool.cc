@@ -0,0 +1,246 @@
+#include "UpstreamPool.h"
+#include "Buffer.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TcpClient.h"
+#include "TcpConnection.h"
+
+namespace myMuduo
+{
+UpstreamPool::UpstreamPool(EventLoop *loop,
+                           const std::string &name,
+                           ResponseParser parser)
+    : loop_(loop), name_(name), parser_(std::move(parser)),
+      connectionsPerEndpoint_(2), maxFailures_(3), ejectionTime_(10.0),
+      started_(false), next_(0)
+{
+}
+
+UpstreamPool::~UpstreamPool()
+{
+    loop_->assertInLoopThread();
+    for (std::unique_ptr<Upstream> &upstream : upstreams_)
+    {
+        if (upstream->conn)
+        {
+            // 连接关闭时（TcpClient析构后异步进行）不能再回调到连接池
+            upstream->conn->setConnectionCallBack([](const TcpConnectionPtr &) {});
+            upstream->conn->setMessageCallBack(
+                [](const TcpConnectionPtr &, Buffer *buf, Timestamp)
+                { buf->retrieveAll(); });
+            upstream->conn.reset();
+        }
+        failPending(upstream.get());
+    }
+    upstreams_.clear();
+}
+
+void UpstreamPool::addEndpoint(const InetAddress &addr)
+{
+    std::unique_ptr<Endpoint> endpoint(new Endpoint);
+    endpoint->addr = addr;
+    endpoints_.push_back(std::move(endpoint));
+}
+
+void UpstreamPool::start()
+{
+    loop_->assertInLoopThread();
+    if (started_)
+    {
+        return;
+    }
+    started_ = true;
+
+    for (std::unique_ptr<Endpoint> &endpoint : endpoints_)
+    {
+        for (int i = 0; i < connectionsPerEndpoint_; ++i)
+        {
+            std::unique_ptr<Upstream> upstream(new Upstream);
+            Upstream *u = upstream.get();
+            u->endpoint = endpoint.get();
+            u->client.reset(new TcpClient(loop_, endpoint->addr, name_));
+            u->client->enableRetry();
+            u->client->setConnectionCallBack(
+                [this, u](const TcpConnectionPtr &conn)
+                { onConnection(u, conn); });
+            u->client->setMessageCallBack(
+                [this, u](const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+                { onMessage(u, conn, buf); });
+            upstreams_.push_back(std::move(upstream));
+        }
+    }
+    // 预热：流量到来之前先建立好所有连接
+    for (std::unique_ptr<Upstream> &upstream : upstreams_)
+    {
+        upstream->client->connect();
+    }
+}
+
+bool UpstreamPool::available(const Upstream *upstream, Timestamp now) const
+{
+    return upstream->conn && upstream->conn->connected() &&
+           now >= upstream->endpoint->ejectedUntil;
+}
+
+bool UpstreamPool::send(std::string_view request, ResponseCallBack cb)
+{
+    loop_->assertInLoopThread();
+    size_t n = upstreams_.size();
+    // 本轮poll返回时缓存的时间就足够判断是否已经过了摘除期
+    Timestamp now = loop_->pollReturnTime();
+
+    Upstream *best = nullptr;
+    size_t bestIndex = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t index = (next_ + i) % n;
+        Upstream *upstream = upstreams_[index].get();
+        if (!available(upstream, now))
+        {
+            continue;
+        }
+        if (best == nullptr || upstream->pending.size() < best->pending.size())
+        {
+            best = upstream;
+            bestIndex = index;
+            if (best->pending.empty())
+            {
+                break;
+            }
+        }
+    }
+    if (best == nullptr)
+    {
+        return false;
+    }
+
+    next_ = (bestIndex + 1) % n;
+    best->pending.push_back(std::move(cb));
+    // 在loop线程中send直接写socket（或者追加到发送队列），不会投递任务
+    best->conn->send(request.data(), request.size());
+    return true;
+}
+
+void UpstreamPool::onConnection(Upstream *upstream,
+                                const TcpConnectionPtr &conn)
+{
+    if (conn->connected())
+    {
+        conn->setTcpNoDelay(true);
+        upstream->conn = conn;
+        LOG_INFO("UpstreamPool [%s] - connected to %s \n", name_.c_str(),
+                 upstream->endpoint->addr.toIpPort().c_str());
+    }
+    else
+    {
+        upstream->conn.reset();
+        if (!upstream->pending.empty())
+        {
+            LOG_ERROR("UpstreamPool [%s] - connection to %s lost with %lu "
+                      "outstanding requests \n",
+                      name_.c_str(),
+                      upstream->endpoint->addr.toIpPort().c_str(),
+                      upstream->pending.size());
+            failPending(upstream);
+            recordFailure(upstream->endpoint);
+        }
+    }
+}
+
+void UpstreamPool::onMessage(Upstream *upstream,
+                             const TcpConnectionPtr &conn,
+                             Buffer *buf)
+{
+    while (buf->readableBytes() > 0)
+    {
+        ssize_t n = parser_(buf);
+        if (n == 0)
+        {
+            break; // 响应还不完整
+        }
+        if (n < 0 || upstream->pending.empty())
+        {
+            // 后端返回了无法解析或者多余的数据，这条连接上的请求和响应已经对不上
+            LOG_ERROR("UpstreamPool [%s] - bad response from %s \n",
+                      name_.c_str(),
+                      upstream->endpoint->addr.toIpPort().c_str());
+            buf->retrieveAll();
+            failPending(upstream);
+            recordFailure(upstream->endpoint);
+            conn->forceClose();
+            return;
+        }
+
+        ResponseCallBack cb = std::move(upstream->pending.front());
+        upstream->pending.pop_front();
+        Endpoint *endpoint = upstream->endpoint;
+        endpoint->failures = 0;
+        ++endpoint->responses;
+        cb(true, std::string_view(buf->peek(), static_cast<size_t>(n)));
+        buf->retrieve(static_cast<size_t>(n));
+    }
+}
+
+void UpstreamPool::failPending(Upstream *upstream)
+{
+    // 回调中可能再次send，先把队列换出来
+    std::deque<ResponseCallBack> pending;
+    pending.swap(upstream->pending);
+    for (ResponseCallBack &cb : pending)
+    {
+        cb(false, std::string_view());
+    }
+}
+
+void UpstreamPool::recordFailure(Endpoint *endpoint)
+{
+    ++endpoint->totalFailures;
+    if (++endpoint->failures >= maxFailures_)
+    {
+        endpoint->failures = 0;
+        endpoint->ejectedUntil =
+            addTime(Timestamp::now(), ejectionTime_);
+        LOG_ERROR("UpstreamPool [%s] - eject %s for %.1f seconds \n",
+                  name_.c_str(), endpoint->addr.toIpPort().c_str(),
+                  ejectionTime_);
+    }
+}
+
+int UpstreamPool::connectedCount() const
+{
+    int count = 0;
+    for (const std::unique_ptr<Upstream> &upstream : upstreams_)
+    {
+        if (upstream->conn && upstream->conn->connected())
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::vector<UpstreamPool::EndpointStatus> UpstreamPool::status() const
+{
+    Timestamp now = Timestamp::now();
+    std::vector<EndpointStatus> result;
+    for (const std::unique_ptr<Endpoint> &endpoint : endpoints_)
+    {
+        EndpointStatus s{endpoint->addr, 0, 0, endpoint->responses,
+                         endpoint->totalFailures,
+                         now < endpoint->ejectedUntil};
+        for (const std::unique_ptr<Upstream> &upstream : upstreams_)
+        {
+            if (upstream->endpoint == endpoint.get())
+            {
+                if (upstream->conn && upstream->conn->connected())
+                {
+                    ++s.connected;
+                }
+                s.outstanding += upstream->pending.size();
+            }
+        }
+        result.push_back(s);
+    }
+    return result;
+}
+} // namespace myMuduo